@@ -27,16 +27,29 @@
 #include "shibokennormalize_p.h"
 #include <reporthandler.h>
 #include <typedatabase.h>
+#include <fileout.h>
 
 #include <QtCore/QDir>
 #include <QtCore/QTextStream>
 #include <QtCore/QDebug>
+#include <QtCore/QFileInfo>
+#include <QtCore/QVector>
+#include <QtCore/QThreadStorage>
 #include <QMetaType>
 
 QHash<QString, QString> CppGenerator::m_nbFuncs = QHash<QString, QString>();
 QHash<QString, QString> CppGenerator::m_sqFuncs = QHash<QString, QString>();
 QHash<QString, QString> CppGenerator::m_mpFuncs = QHash<QString, QString>();
-QString CppGenerator::m_currentErrorCode("0");
+
+// Each thread generating code has its own error code.
+static QThreadStorage<QString*> currentErrorCodeStorage;
+
+QString& CppGenerator::currentErrorCode()
+{
+    if (!currentErrorCodeStorage.hasLocalData())
+        currentErrorCodeStorage.setLocalData(new QString("0"));
+    return *currentErrorCodeStorage.localData();
+}
 
 // utility functions
 inline AbstractMetaType* getTypeWithoutContainer(AbstractMetaType* arg)
@@ -59,6 +72,18 @@ static QString reduceTypeName(const AbstractMetaClass* metaClass)
     return QString();
 }
 
+/*
+ * Returns the expression used to convert the C++ result of \p func to Python.
+ * Value-type temporaries not used by injected code are moved into the new wrapper.
+ */
+static QString cppResultForConversion(const AbstractMetaFunction* func)
+{
+    const AbstractMetaType* type = func->type();
+    if (type->isValue() && !type->isReference() && !type->isConstant() && !func->hasInjectedCode())
+        return "SBK_MOVE(" CPP_RETURN_VAR ")";
+    return CPP_RETURN_VAR;
+}
+
 CppGenerator::CppGenerator()
 {
     // Number protocol structure members names
@@ -119,7 +144,7 @@ CppGenerator::CppGenerator()
 
 QString CppGenerator::fileNameForClass(const AbstractMetaClass *metaClass) const
 {
-    return metaClass->qualifiedCppName().toLower().replace("::", "_") + QLatin1String("_wrapper.cpp");
+    return fileNameForClassSource(metaClass);
 }
 
 QList<AbstractMetaFunctionList> CppGenerator::filterGroupedOperatorFunctions(const AbstractMetaClass* metaClass,
@@ -228,11 +253,18 @@ bool CppGenerator::hasBoolCast(const AbstractMetaClass* metaClass) const
 */
 void CppGenerator::generateClass(QTextStream &s, const AbstractMetaClass *metaClass)
 {
-    ReportHandler::debugSparse("Generating wrapper implementation for " + metaClass->fullName());
+    if (writeUnchangedClassCode(s, metaClass) || writeCodeGeneratedInParallel(s, metaClass))
+        return;
+
+    ShibokenGenerator::debugSparse("Generating wrapper implementation for " + metaClass->fullName());
+    StatisticsCollector statistics(s, metaClass);
 
     // write license comment
     s << licenseComment() << endl;
 
+    if (useSharedConverters())
+        s << "#define " << sharedConvertersMacro() << endl << endl;
+
     if (!avoidProtectedHack() && !metaClass->isNamespace() && !metaClass->hasPrivateDestructor()) {
         s << "//workaround to access protected functions" << endl;
         s << "#define protected public" << endl << endl;
@@ -290,8 +322,8 @@ void CppGenerator::generateClass(QTextStream &s, const AbstractMetaClass *metaCl
     if (metaClass->typeEntry()->typeFlags() & ComplexTypeEntry::Deprecated)
         s << "#Deprecated" << endl;
 
-    //Use class base namespace
-    const AbstractMetaClass *context = metaClass->enclosingClass();
+    //Use class base namespace, unless the directive would leak into the other wrappers of a unity file
+    const AbstractMetaClass *context = unityBuildFiles() > 0 ? 0 : metaClass->enclosingClass();
     while(context) {
         if (context->isNamespace() && !context->enclosingClass()) {
             s << "using namespace " << context->qualifiedCppName() << ";" << endl;
@@ -386,6 +418,10 @@ void CppGenerator::generateClass(QTextStream &s, const AbstractMetaClass *metaCl
                 smd << endl << "};" << endl << endl;
             }
             writeMethodDefinition(md, overloads);
+            if (hasAsyncVariant(overloads)) {
+                writeAsyncMethodWrapper(s, overloads);
+                writeAsyncMethodDefinition(md, overloads);
+            }
         }
     }
 
@@ -427,10 +463,13 @@ void CppGenerator::generateClass(QTextStream &s, const AbstractMetaClass *metaCl
         s << "static int " << cpythonBaseName(metaClass) << "___nb_bool(PyObject* " PYTHON_SELF_VAR ")" << endl;
         s << '{' << endl;
         writeCppSelfDefinition(s, metaClass);
+        bool releaseGil = shouldReleaseGil(metaClass->findFunction("isNull"));
         s << INDENT << "int result;" << endl;
-        s << INDENT << BEGIN_ALLOW_THREADS << endl;
+        if (releaseGil)
+            s << INDENT << BEGIN_ALLOW_THREADS << endl;
         s << INDENT << "result = !" CPP_SELF_VAR "->isNull();" << endl;
-        s << INDENT << END_ALLOW_THREADS << endl;
+        if (releaseGil)
+            s << INDENT << END_ALLOW_THREADS << endl;
         s << INDENT << "return result;" << endl;
         s << '}' << endl << endl;
     }
@@ -561,6 +600,11 @@ void CppGenerator::writeDestructorNative(QTextStream &s, const AbstractMetaClass
     Indentation indentation(INDENT);
     s << wrapperName(metaClass) << "::~" << wrapperName(metaClass) << "()" << endl << '{' << endl;
     // kill pyobject
+    s << INDENT << "if (Shiboken::BindingManager::instance().deferWrapperInvalidation(this))" << endl;
+    {
+        Indentation indentation(INDENT);
+        s << INDENT << "return;" << endl;
+    }
     s << INDENT << "SbkObject* wrapper = Shiboken::BindingManager::instance().retrieveWrapper(this);" << endl;
     s << INDENT << "Shiboken::Object::destroy(wrapper, this);" << endl;
     s << '}' << endl;
@@ -628,7 +672,7 @@ void CppGenerator::writeVirtualMethodNative(QTextStream&s, const AbstractMetaFun
                     while ((offset = regex.indexIn(defaultReturnExpr, offset)) != -1) {
                         int argId = regex.cap(1).toInt() - 1;
                         if (argId < 0 || argId > func->arguments().count()) {
-                            ReportHandler::warning("The expression used in return value contains an invalid index.");
+                            ShibokenGenerator::warning("The expression used in return value contains an invalid index.");
                             break;
                         }
                         defaultReturnExpr.replace(regex.cap(0), func->arguments()[argId]->name());
@@ -640,13 +684,13 @@ void CppGenerator::writeVirtualMethodNative(QTextStream&s, const AbstractMetaFun
             defaultReturnExpr = minimalConstructor(func->type());
         if (defaultReturnExpr.isEmpty()) {
             QString errorMsg = QString(MIN_CTOR_ERROR_MSG).arg(func->type()->cppSignature());
-            ReportHandler::warning(errorMsg);
+            ShibokenGenerator::warning(errorMsg);
             s << endl << INDENT << "#error " << errorMsg << endl;
         }
     }
 
     if (func->isAbstract() && func->isModifiedRemoved()) {
-        ReportHandler::warning(QString("Pure virtual method '%1::%2' must be implement but was "\
+        ShibokenGenerator::warning(QString("Pure virtual method '%1::%2' must be implement but was "\
                                        "completely removed on type system.")
                                   .arg(func->ownerClass()->name())
                                   .arg(func->minimalSignature()));
@@ -664,6 +708,8 @@ void CppGenerator::writeVirtualMethodNative(QTextStream&s, const AbstractMetaFun
     }
 
     s << INDENT << "Shiboken::GilState gil;" << endl;
+    if (useCallStatistics())
+        writeCallTimer(s, "virtual " + func->ownerClass()->qualifiedCppName() + "::" + func->minimalSignature());
 
     // Get out of virtual method call if someone already threw an error.
     s << INDENT << "if (PyErr_Occurred())" << endl;
@@ -692,6 +738,9 @@ void CppGenerator::writeVirtualMethodNative(QTextStream&s, const AbstractMetaFun
             s << "()' not implemented.\");" << endl;
             s << INDENT << "return " << (func->type() ? defaultReturnExpr : "");
         } else {
+            // The statistics are only changed with the GIL held.
+            if (useCallStatistics())
+                s << INDENT << "callTimer.stop();" << endl;
             s << INDENT << "gil.release();" << endl;
             s << INDENT << "return this->::" << func->implementingClass()->qualifiedCppName() << "::";
             writeFunctionCall(s, func, Generator::VirtualCall);
@@ -947,7 +996,7 @@ void CppGenerator::writeMethodWrapperPreamble(QTextStream& s, OverloadData& over
             s << INDENT << "if (Shiboken::Object::isUserType(" PYTHON_SELF_VAR ") && !Shiboken::ObjectType::canCallConstructor(" PYTHON_SELF_VAR "->ob_type, Shiboken::SbkType< ::";
             s << ownerClass->qualifiedCppName() << " >()))" << endl;
             Indentation indent(INDENT);
-            s << INDENT << "return " << m_currentErrorCode << ';' << endl << endl;
+            s << INDENT << "return " << currentErrorCode() << ';' << endl << endl;
         }
         // Declare pointer for the underlying C++ object.
         s << INDENT << "::";
@@ -987,7 +1036,7 @@ void CppGenerator::writeMethodWrapperPreamble(QTextStream& s, OverloadData& over
 void CppGenerator::writeConstructorWrapper(QTextStream& s, const AbstractMetaFunctionList overloads)
 {
     ErrorCode errorCode(-1);
-    OverloadData overloadData(overloads, this);
+    OverloadData& overloadData = getOverloadData(overloads);
 
     const AbstractMetaFunction* rfunc = overloadData.referenceFunction();
     const AbstractMetaClass* metaClass = rfunc->ownerClass();
@@ -996,6 +1045,9 @@ void CppGenerator::writeConstructorWrapper(QTextStream& s, const AbstractMetaFun
     s << cpythonFunctionName(rfunc) << "(PyObject* " PYTHON_SELF_VAR ", PyObject* args, PyObject* kwds)" << endl;
     s << '{' << endl;
 
+    if (useCallStatistics())
+        writeCallTimer(s, fullPythonFunctionName(rfunc) + ".__init__", overloadData.overloads().count());
+
     QSet<QString> argNamesSet;
     if (usePySideExtensions() && metaClass->isQObject()) {
         // Write argNames variable with all known argument names.
@@ -1032,7 +1084,7 @@ void CppGenerator::writeConstructorWrapper(QTextStream& s, const AbstractMetaFun
                 s << INDENT << "\"'" << metaClass->qualifiedCppName();
             }
             s << "' represents a C++ abstract class and cannot be instantiated\");" << endl;
-            s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+            s << INDENT << "return " << currentErrorCode() << ';' << endl;
         }
         s << INDENT << '}' << endl << endl;
     }
@@ -1073,7 +1125,7 @@ void CppGenerator::writeConstructorWrapper(QTextStream& s, const AbstractMetaFun
     {
         Indentation indent(INDENT);
         s << INDENT << "delete cptr;" << endl;
-        s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+        s << INDENT << "return " << currentErrorCode() << ';' << endl;
     }
     s << INDENT << '}' << endl;
     if (overloadData.maxArgs() > 0) {
@@ -1098,7 +1150,7 @@ void CppGenerator::writeConstructorWrapper(QTextStream& s, const AbstractMetaFun
         s << INDENT << "if (kwds && !PySide::fillQtProperties(" PYTHON_SELF_VAR ", metaObject, kwds, argNames, " << argNamesSet.count() << "))" << endl;
         {
             Indentation indentation(INDENT);
-            s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+            s << INDENT << "return " << currentErrorCode() << ';' << endl;
         }
     }
 
@@ -1142,7 +1194,7 @@ void CppGenerator::writeConstructorWrapper(QTextStream& s, const AbstractMetaFun
 
 void CppGenerator::writeMethodWrapper(QTextStream& s, const AbstractMetaFunctionList overloads)
 {
-    OverloadData overloadData(overloads, this);
+    OverloadData& overloadData = getOverloadData(overloads);
     const AbstractMetaFunction* rfunc = overloadData.referenceFunction();
 
     int maxArgs = overloadData.maxArgs();
@@ -1156,6 +1208,9 @@ void CppGenerator::writeMethodWrapper(QTextStream& s, const AbstractMetaFunction
     }
     s << ')' << endl << '{' << endl;
 
+    if (useCallStatistics())
+        writeCallTimer(s, fullPythonFunctionName(rfunc), overloadData.overloads().count());
+
     writeMethodWrapperPreamble(s, overloadData);
 
     s << endl;
@@ -1240,6 +1295,36 @@ void CppGenerator::writeMethodWrapper(QTextStream& s, const AbstractMetaFunction
     s << '}' << endl << endl;
 }
 
+void CppGenerator::writeCallTimer(QTextStream& s, const QString& name, int overloadCount)
+{
+    if (overloadCount > 1)
+        s << INDENT << "static unsigned long overloadCalls[" << overloadCount << "];" << endl;
+    s << INDENT << "static Shiboken::FunctionCallStatistics callStatistics = { \"" << name << "\", ";
+    s << overloadCount << ", " << (overloadCount > 1 ? "overloadCalls" : "0") << " };" << endl;
+    s << INDENT << "Shiboken::CallTimer callTimer(callStatistics);" << endl;
+}
+
+bool CppGenerator::hasAsyncVariant(const AbstractMetaFunctionList& overloads) const
+{
+    // Type slots have no method definition the asynchronous one could go with.
+    if (m_tpFuncs.contains(overloads.first()->name()))
+        return false;
+    foreach (const AbstractMetaFunction* func, overloads) {
+        if (!func->allowThread() || func->isStatic() || !func->ownerClass())
+            return false;
+    }
+    return true;
+}
+
+void CppGenerator::writeAsyncMethodWrapper(QTextStream& s, const AbstractMetaFunctionList overloads)
+{
+    const AbstractMetaFunction* rfunc = overloads.first();
+    s << "static PyObject* " << cpythonFunctionName(rfunc) << "_async(PyObject* " PYTHON_SELF_VAR ", PyObject* args, PyObject* kwds)" << endl;
+    s << '{' << endl;
+    s << INDENT << "return Shiboken::Async::callMethod(" PYTHON_SELF_VAR ", \"" << rfunc->name() << "\", args, kwds);" << endl;
+    s << '}' << endl << endl;
+}
+
 void CppGenerator::writeArgumentsInitializer(QTextStream& s, OverloadData& overloadData)
 {
     const AbstractMetaFunction* rfunc = overloadData.referenceFunction();
@@ -1274,7 +1359,7 @@ void CppGenerator::writeArgumentsInitializer(QTextStream& s, OverloadData& overl
             {
                 Indentation indent(INDENT);
                 s << INDENT << "PyErr_SetString(PyExc_TypeError, \"" << fullPythonFunctionName(rfunc) << "(): too many arguments\");" << endl;
-                s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+                s << INDENT << "return " << currentErrorCode() << ';' << endl;
             }
             s << INDENT << '}';
         }
@@ -1287,7 +1372,7 @@ void CppGenerator::writeArgumentsInitializer(QTextStream& s, OverloadData& overl
             {
                 Indentation indent(INDENT);
                 s << INDENT << "PyErr_SetString(PyExc_TypeError, \"" << fullPythonFunctionName(rfunc) << "(): not enough arguments\");" << endl;
-                s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+                s << INDENT << "return " << currentErrorCode() << ';' << endl;
             }
             s << INDENT << '}';
         }
@@ -1325,7 +1410,7 @@ void CppGenerator::writeArgumentsInitializer(QTextStream& s, OverloadData& overl
     s << ", " << palist.join(", ") << "))" << endl;
     {
         Indentation indent(INDENT);
-        s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+        s << INDENT << "return " << currentErrorCode() << ';' << endl;
     }
     s << endl;
 }
@@ -1473,7 +1558,7 @@ void CppGenerator::writeErrorSection(QTextStream& s, OverloadData& overloadData)
         s << INDENT << "const char* overloads[] = {" << overloadSignatures.join(", ") << ", 0};" << endl;
         s << INDENT << "Shiboken::setErrorAboutWrongArguments(" << argsVar << ", \"" << funcName << "\", overloads);" << endl;
     }
-    s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+    s << INDENT << "return " << currentErrorCode() << ';' << endl;
 }
 
 void CppGenerator::writeFunctionReturnErrorCheckSection(QTextStream& s, bool hasReturnValue)
@@ -1483,7 +1568,7 @@ void CppGenerator::writeFunctionReturnErrorCheckSection(QTextStream& s, bool has
         Indentation indent(INDENT);
         if (hasReturnValue)
             s << INDENT << "Py_XDECREF(" PYTHON_RETURN_VAR ");" << endl;
-        s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+        s << INDENT << "return " << currentErrorCode() << ';' << endl;
     }
     s << INDENT << '}' << endl;
 }
@@ -1492,7 +1577,7 @@ void CppGenerator::writeInvalidPyObjectCheck(QTextStream& s, const QString& pyOb
 {
     s << INDENT << "if (!Shiboken::Object::isValid(" << pyObj << "))" << endl;
     Indentation indent(INDENT);
-    s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+    s << INDENT << "return " << currentErrorCode() << ';' << endl;
 }
 
 void CppGenerator::writeTypeCheck(QTextStream& s, const AbstractMetaType* argType, QString argumentName, bool isNumber, QString customType, bool rejectNull)
@@ -1561,7 +1646,7 @@ void CppGenerator::writeArgumentConversion(QTextStream& s,
 const AbstractMetaType* CppGenerator::getArgumentType(const AbstractMetaFunction* func, int argPos)
 {
     if (argPos < 0 || argPos > func->arguments().size()) {
-        ReportHandler::warning(QString("Argument index for function '%1' out of range.").arg(func->signature()));
+        ShibokenGenerator::warning(QString("Argument index for function '%1' out of range.").arg(func->signature()));
         return 0;
     }
 
@@ -1572,7 +1657,7 @@ const AbstractMetaType* CppGenerator::getArgumentType(const AbstractMetaFunction
     else
         argType = buildAbstractMetaTypeFromString(typeReplaced);
     if (!argType && !m_knownPythonTypes.contains(typeReplaced)) {
-        ReportHandler::warning(QString("Unknown type '%1' used as argument type replacement "\
+        ShibokenGenerator::warning(QString("Unknown type '%1' used as argument type replacement "\
                                        "in function '%2', the generated code may be broken.")
                                       .arg(typeReplaced)
                                       .arg(func->signature()));
@@ -1838,6 +1923,8 @@ void CppGenerator::writeFunctionCalls(QTextStream& s, const OverloadData& overlo
 {
     QList<const AbstractMetaFunction*> overloads = overloadData.overloadsWithoutRepetition();
     s << INDENT << "// Call function/method" << endl;
+    if (useCallStatistics() && overloads.count() > 1)
+        s << INDENT << "callTimer.overloadChosen(overloadId);" << endl;
     s << INDENT << (overloads.count() > 1 ? "switch (overloadId) " : "") << '{' << endl;
     {
         Indentation indent(INDENT);
@@ -1870,7 +1957,7 @@ void CppGenerator::writeSingleFunctionCall(QTextStream& s, const OverloadData& o
 
     if (func->functionType() == AbstractMetaFunction::EmptyFunction) {
         s << INDENT << "PyErr_Format(PyExc_TypeError, \"%s is a private method.\", \"" << func->signature().replace("::", ".") << "\");" << endl;
-        s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+        s << INDENT << "return " << currentErrorCode() << ';' << endl;
         return;
     }
 
@@ -1970,7 +2057,7 @@ void CppGenerator::writeNamedArgumentResolution(QTextStream& s, const AbstractMe
                 Indentation indent(INDENT);
                 s << INDENT << "PyErr_Format(PyExc_TypeError, \"" << fullPythonFunctionName(func);
                 s << "(): got multiple values for keyword argument '%s'\", errorArgName);" << endl;
-                s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+                s << INDENT << "return " << currentErrorCode() << ';' << endl;
             }
             s << INDENT << '}' << endl;
 
@@ -1992,7 +2079,7 @@ QString CppGenerator::argumentNameFromIndex(const AbstractMetaFunction* func, in
             pyArgName = PYTHON_RETURN_VAR;
             *wrappedClass = classes().findClass(returnType->typeEntry()->name());
         } else {
-            ReportHandler::warning("Invalid Argument index on function modification: " + func->name());
+            ShibokenGenerator::warning("Invalid Argument index on function modification: " + func->name());
         }
     } else {
         int realIndex = argIndex - 1 - OverloadData::numberOfRemovedArguments(func, argIndex - 1);
@@ -2029,7 +2116,7 @@ void CppGenerator::writeMethodCall(QTextStream& s, const AbstractMetaFunction* f
             Indentation indent(INDENT);
             s << INDENT << "PyErr_SetString(PyExc_NotImplementedError, \"pure virtual method '";
             s << func->ownerClass()->name() << '.' << func->name() << "()' not implemented.\");" << endl;
-            s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+            s << INDENT << "return " << currentErrorCode() << ';' << endl;
         }
         s << INDENT << "}\n";
     }
@@ -2219,7 +2306,17 @@ void CppGenerator::writeMethodCall(QTextStream& s, const AbstractMetaFunction* f
         }
 
         if (!injectedCodeCallsCppFunction(func)) {
-            s << INDENT << BEGIN_ALLOW_THREADS << endl << INDENT;
+            bool releaseGil = shouldReleaseGil(func);
+            bool timeGilHold = !releaseGil && useGilHoldDiagnostics();
+            if (releaseGil) {
+                if (useCallStatistics())
+                    s << INDENT << "callTimer.releasingGil();" << endl;
+                s << INDENT << BEGIN_ALLOW_THREADS << endl;
+            } else if (timeGilHold) {
+                QString signature = func->ownerClass() ? func->ownerClass()->qualifiedCppName() + "::" : QString();
+                s << INDENT << "Shiboken::GilHoldTimer gilHoldTimer(\"" << signature << func->minimalSignature() << "\");" << endl;
+            }
+            s << INDENT;
             if (isCtor) {
                 s << "cptr = ";
             } else if (func->type() && !func->isInplaceOperator()) {
@@ -2243,14 +2340,19 @@ void CppGenerator::writeMethodCall(QTextStream& s, const AbstractMetaFunction* f
                 s << " " CPP_RETURN_VAR " = ";
             }
             s << methodCall << ';' << endl;
-            s << INDENT << END_ALLOW_THREADS << endl;
+            if (releaseGil) {
+                s << INDENT << END_ALLOW_THREADS << endl;
+                if (useCallStatistics())
+                    s << INDENT << "callTimer.gilAcquired();" << endl;
+            } else if (timeGilHold)
+                s << INDENT << "gilHoldTimer.stop();" << endl;
 
             if (!func->conversionRule(TypeSystem::TargetLangCode, 0).isEmpty()) {
                 writeConversionRule(s, func, TypeSystem::TargetLangCode, PYTHON_RETURN_VAR);
             } else if (!isCtor && !func->isInplaceOperator() && func->type()
                 && !injectedCodeHasReturnValueAttribution(func, TypeSystem::TargetLangCode)) {
                 s << INDENT << PYTHON_RETURN_VAR " = ";
-                writeToPythonConversion(s, func->type(), func->ownerClass(), CPP_RETURN_VAR);
+                writeToPythonConversion(s, func->type(), func->ownerClass(), cppResultForConversion(func));
                 s << ';' << endl;
             }
         }
@@ -2319,7 +2421,7 @@ void CppGenerator::writeMethodCall(QTextStream& s, const AbstractMetaFunction* f
             if (refCount.action != ReferenceCount::Set
                 && refCount.action != ReferenceCount::Remove
                 && refCount.action != ReferenceCount::Add) {
-                ReportHandler::warning("\"set\", \"add\" and \"remove\" are the only values supported by Shiboken for action attribute of reference-count tag.");
+                ShibokenGenerator::warning("\"set\", \"add\" and \"remove\" are the only values supported by Shiboken for action attribute of reference-count tag.");
                 continue;
             }
             const AbstractMetaClass* wrappedClass = 0;
@@ -2335,19 +2437,25 @@ void CppGenerator::writeMethodCall(QTextStream& s, const AbstractMetaFunction* f
                 }
             }
 
-            if (refCount.action == ReferenceCount::Add || refCount.action == ReferenceCount::Set)
-                s << INDENT << "Shiboken::Object::keepReference(";
-            else
-                s << INDENT << "Shiboken::Object::removeReference(";
-
-            s << "reinterpret_cast<SbkObject*>(" PYTHON_SELF_VAR "), \"";
             QString varName = arg_mod.referenceCounts.first().varName;
             if (varName.isEmpty())
                 varName = func->minimalSignature() + QString().number(arg_mod.index);
 
-            s << varName << "\", " << pyArgName
-              << (refCount.action == ReferenceCount::Add ? ", true" : "")
-              << ");" << endl;
+            // The reference slot is looked up only on the first call.
+            s << INDENT << '{' << endl;
+            {
+                Indentation indent(INDENT);
+                s << INDENT << "static const int refSlot = Shiboken::Object::referenceSlot(\"" << varName << "\");" << endl;
+                if (refCount.action == ReferenceCount::Add || refCount.action == ReferenceCount::Set)
+                    s << INDENT << "Shiboken::Object::keepReference(";
+                else
+                    s << INDENT << "Shiboken::Object::removeReference(";
+
+                s << "reinterpret_cast<SbkObject*>(" PYTHON_SELF_VAR "), refSlot, " << pyArgName
+                  << (refCount.action == ReferenceCount::Add ? ", true" : "")
+                  << ");" << endl;
+            }
+            s << INDENT << '}' << endl;
 
             if (arg_mod.index == 0)
                 hasReturnPolicy = true;
@@ -2375,13 +2483,14 @@ void CppGenerator::writeMultipleInheritanceInitializerFunction(QTextStream& s, c
 {
     QString className = metaClass->qualifiedCppName();
     QStringList ancestors = getAncestorMultipleInheritance(metaClass);
-    s << "static int mi_offsets[] = { ";
-    for (int i = 0; i < ancestors.size(); i++)
-        s << "-1, ";
-    s << "-1 };" << endl;
     s << "int*" << endl;
     s << multipleInheritanceInitializerFunctionName(metaClass) << "(const void* cptr)" << endl;
     s << '{' << endl;
+    // Local to the function, so that many wrappers can be compiled in the same unity build file.
+    s << INDENT << "static int mi_offsets[] = { ";
+    for (int i = 0; i < ancestors.size(); i++)
+        s << "-1, ";
+    s << "-1 };" << endl;
     s << INDENT << "if (mi_offsets[0] == -1) {" << endl;
     {
         Indentation indent(INDENT);
@@ -2472,8 +2581,7 @@ void CppGenerator::writeExtendedConverterInitialization(QTextStream& s, const Ty
 {
     s << INDENT << "// Extended implicit conversions for " << externalType->targetLangPackage() << '.' << externalType->name() << endl;
     s << INDENT << "shiboType = reinterpret_cast<SbkObjectType*>(";
-    s << cppApiVariableName(externalType->targetLangPackage()) << '[';
-    s << getTypeIndexVariableName(externalType) << "]);" << endl;
+    s << cpythonTypeNameExt(externalType) << ");" << endl;
     s << INDENT << "Shiboken::ObjectType::setExternalIsConvertibleFunction(shiboType, " << extendedIsConvertibleFunctionName(externalType) << ");" << endl;
     s << INDENT << "Shiboken::ObjectType::setExternalCppConversionFunction(shiboType, " << extendedToCppFunctionName(externalType) << ");" << endl;
 }
@@ -2591,15 +2699,15 @@ void CppGenerator::writeClassDefinition(QTextStream& s, const AbstractMetaClass*
         tp_getset = cpythonGettersSettersDefinitionName(metaClass);
 
     // search for special functions
-    ShibokenGenerator::clearTpFuncs();
+    QHash<QString, QString> tpFuncs = m_tpFuncs;
     foreach (AbstractMetaFunction* func, metaClass->functions()) {
-        if (m_tpFuncs.contains(func->name()))
-            m_tpFuncs[func->name()] = cpythonFunctionName(func);
+        if (tpFuncs.contains(func->name()))
+            tpFuncs[func->name()] = cpythonFunctionName(func);
     }
-    if (m_tpFuncs["__repr__"] == "0"
+    if (tpFuncs["__repr__"] == "0"
         && !metaClass->isQObject()
         && metaClass->hasToStringCapability()) {
-        m_tpFuncs["__repr__"] = writeReprFunction(s, metaClass);
+        tpFuncs["__repr__"] = writeReprFunction(s, metaClass);
     }
 
     // class or some ancestor has multiple inheritance
@@ -2631,13 +2739,13 @@ void CppGenerator::writeClassDefinition(QTextStream& s, const AbstractMetaClass*
     s << INDENT << "/*tp_getattr*/          0," << endl;
     s << INDENT << "/*tp_setattr*/          0," << endl;
     s << INDENT << "/*tp_compare*/          0," << endl;
-    s << INDENT << "/*tp_repr*/             " << m_tpFuncs["__repr__"] << "," << endl;
+    s << INDENT << "/*tp_repr*/             " << tpFuncs["__repr__"] << "," << endl;
     s << INDENT << "/*tp_as_number*/        0," << endl;
     s << INDENT << "/*tp_as_sequence*/      0," << endl;
     s << INDENT << "/*tp_as_mapping*/       0," << endl;
     s << INDENT << "/*tp_hash*/             " << tp_hash << ',' << endl;
     s << INDENT << "/*tp_call*/             " << tp_call << ',' << endl;
-    s << INDENT << "/*tp_str*/              " << m_tpFuncs["__str__"] << ',' << endl;
+    s << INDENT << "/*tp_str*/              " << tpFuncs["__str__"] << ',' << endl;
     s << INDENT << "/*tp_getattro*/         " << tp_getattro << ',' << endl;
     s << INDENT << "/*tp_setattro*/         " << tp_setattro << ',' << endl;
     s << INDENT << "/*tp_as_buffer*/        0," << endl;
@@ -2647,8 +2755,8 @@ void CppGenerator::writeClassDefinition(QTextStream& s, const AbstractMetaClass*
     s << INDENT << "/*tp_clear*/            " << className << "_clear," << endl;
     s << INDENT << "/*tp_richcompare*/      " << tp_richcompare << ',' << endl;
     s << INDENT << "/*tp_weaklistoffset*/   0," << endl;
-    s << INDENT << "/*tp_iter*/             " << m_tpFuncs["__iter__"] << ',' << endl;
-    s << INDENT << "/*tp_iternext*/         " << m_tpFuncs["__next__"] << ',' << endl;
+    s << INDENT << "/*tp_iter*/             " << tpFuncs["__iter__"] << ',' << endl;
+    s << INDENT << "/*tp_iternext*/         " << tpFuncs["__next__"] << ',' << endl;
     s << INDENT << "/*tp_methods*/          " << className << "_methods," << endl;
     s << INDENT << "/*tp_members*/          0," << endl;
     s << INDENT << "/*tp_getset*/           " << tp_getset << ',' << endl;
@@ -2919,9 +3027,9 @@ void CppGenerator::writeGetterFunction(QTextStream& s, const AbstractMetaField*
 
     s << INDENT << "PyObject* value = ";
     if (newWrapperSameObject) {
-        s << "Shiboken::Object::newObject((SbkObjectType*)" << cpythonTypeNameExt(fieldType);
-        s << ", " << cppField << ", false, true);" << endl;
-        s << INDENT << "Shiboken::Object::setParent(" PYTHON_SELF_VAR ", value)";
+        // The field wrapper is cached by the owner, repeated accesses return the same object.
+        s << "Shiboken::Object::fieldView(reinterpret_cast<SbkObject*>(" PYTHON_SELF_VAR "), ";
+        s << "(SbkObjectType*)" << cpythonTypeNameExt(fieldType) << ", " << cppField << ")";
     } else {
         writeToPythonConversion(s, fieldType, metaField->enclosingClass(), cppField);
     }
@@ -2977,8 +3085,8 @@ void CppGenerator::writeSetterFunction(QTextStream& s, const AbstractMetaField*
     s << INDENT << conversion << ';' << endl << endl;
 
     if (isPointerToWrapperType(fieldType)) {
-        s << INDENT << "Shiboken::Object::keepReference(reinterpret_cast<SbkObject*>(" PYTHON_SELF_VAR "), \"";
-        s << metaField->name() << "\", value);" << endl;
+        s << INDENT << "static const int refSlot = Shiboken::Object::referenceSlot(\"" << metaField->name() << "\");" << endl;
+        s << INDENT << "Shiboken::Object::keepReference(reinterpret_cast<SbkObject*>(" PYTHON_SELF_VAR "), refSlot, value);" << endl;
     }
 
     s << INDENT << "return 0;" << endl;
@@ -3018,7 +3126,7 @@ void CppGenerator::writeRichCompareFunction(QTextStream& s, const AbstractMetaCl
             }
 
             bool first = true;
-            OverloadData overloadData(overloads, this);
+            OverloadData& overloadData = getOverloadData(overloads);
             foreach (OverloadData* data, overloadData.nextOverloadData()) {
                 const AbstractMetaFunction* func = data->referenceFunction();
                 if (func->isStatic())
@@ -3053,7 +3161,7 @@ void CppGenerator::writeRichCompareFunction(QTextStream& s, const AbstractMetaCl
                         s << expression << ';' << endl;
                         s << INDENT << PYTHON_RETURN_VAR " = ";
                         if (func->type())
-                            writeToPythonConversion(s, func->type(), metaClass, CPP_RETURN_VAR);
+                            writeToPythonConversion(s, func->type(), metaClass, cppResultForConversion(func));
                         else
                             s << "Py_None;" << endl << INDENT << "Py_INCREF(Py_None)";
                         s << ';' << endl;
@@ -3090,14 +3198,14 @@ void CppGenerator::writeRichCompareFunction(QTextStream& s, const AbstractMetaCl
     }
     s << INDENT << baseName << "_RichComparison_TypeError:" << endl;
     s << INDENT << "PyErr_SetString(PyExc_NotImplementedError, \"operator not implemented.\");" << endl;
-    s << INDENT << "return " << m_currentErrorCode << ';' << endl << endl;
+    s << INDENT << "return " << currentErrorCode() << ';' << endl << endl;
     s << '}' << endl << endl;
 }
 
 void CppGenerator::writeMethodDefinitionEntry(QTextStream& s, const AbstractMetaFunctionList overloads)
 {
     Q_ASSERT(!overloads.isEmpty());
-    OverloadData overloadData(overloads, this);
+    OverloadData& overloadData = getOverloadData(overloads);
     bool usePyArgs = pythonFunctionWrapperUsesListOfArguments(overloadData);
     const AbstractMetaFunction* func = overloadData.referenceFunction();
     int min = overloadData.minArgs();
@@ -3136,7 +3244,16 @@ void CppGenerator::writeMethodDefinition(QTextStream& s, const AbstractMetaFunct
     s << ',' << endl;
 }
 
-void CppGenerator::writeEnumsInitialization(QTextStream& s, AbstractMetaEnumList& enums)
+void CppGenerator::writeAsyncMethodDefinition(QTextStream& s, const AbstractMetaFunctionList overloads)
+{
+    const AbstractMetaFunction* rfunc = overloads.first();
+    if (m_tpFuncs.contains(rfunc->name()))
+        return;
+    s << INDENT << "{\"" << rfunc->name() << "_async\", (PyCFunction)" << cpythonFunctionName(rfunc);
+    s << "_async, METH_VARARGS|METH_KEYWORDS}," << endl;
+}
+
+void CppGenerator::writeEnumsInitialization(QTextStream& s, AbstractMetaEnumList& enums, bool timeSteps)
 {
     if (enums.isEmpty())
         return;
@@ -3144,6 +3261,8 @@ void CppGenerator::writeEnumsInitialization(QTextStream& s, AbstractMetaEnumList
     foreach (const AbstractMetaEnum* cppEnum, enums) {
         if (cppEnum->isPrivate())
             continue;
+        if (timeSteps)
+            writeInitTimerStep(s, cppEnum->isAnonymous() ? QString("anonymous enum") : "enum " + cppEnum->name());
         writeEnumInitialization(s, cppEnum);
     }
 }
@@ -3168,8 +3287,8 @@ void CppGenerator::writeEnumInitialization(QTextStream& s, const AbstractMetaEnu
     if (!cppEnum->isAnonymous()) {
         FlagsTypeEntry* flags = cppEnum->typeEntry()->flags();
         if (flags)
-            s << INDENT << cpythonTypeNameExt(flags) << " = &" << cpythonTypeName(flags) << ';' << endl;
-        s << INDENT << cpythonTypeNameExt(cppEnum->typeEntry()) << " = Shiboken::Enum::";
+            s << INDENT << cpythonTypeSlot(flags) << " = &" << cpythonTypeName(flags) << ';' << endl;
+        s << INDENT << cpythonTypeSlot(cppEnum->typeEntry()) << " = Shiboken::Enum::";
         s << ((enclosingClass || hasUpperEnclosingClass) ? "createScopedEnum" : "createGlobalEnum");
         s << '(' << enclosingObjectVariable << ',' << endl;
         {
@@ -3179,13 +3298,13 @@ void CppGenerator::writeEnumInitialization(QTextStream& s, const AbstractMetaEnu
             s << INDENT << '"' << (cppEnum->enclosingClass() ? cppEnum->enclosingClass()->qualifiedCppName() + "::" : "");
             s << cppEnum->name() << '"';
             if (flags)
-                s << ',' << endl << INDENT << cpythonTypeNameExt(flags);
+                s << ',' << endl << INDENT << cpythonTypeSlot(flags);
             s << ");" << endl;
         }
-        s << INDENT << "if (!" << cpythonTypeNameExt(cppEnum->typeEntry()) << ')' << endl;
+        s << INDENT << "if (!" << cpythonTypeSlot(cppEnum->typeEntry()) << ')' << endl;
         {
             Indentation indent(INDENT);
-            s << INDENT << "return " << m_currentErrorCode << ';' << endl << endl;
+            s << INDENT << "return " << currentErrorCode() << ';' << endl << endl;
         }
     }
 
@@ -3213,7 +3332,7 @@ void CppGenerator::writeEnumInitialization(QTextStream& s, const AbstractMetaEnu
                     s << ")->super.ht_type.tp_dict, \"" << enumValue->name() << "\", anonEnumItem) < 0)" << endl;
                     {
                         Indentation indent(INDENT);
-                        s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+                        s << INDENT << "return " << currentErrorCode() << ';' << endl;
                     }
                     s << INDENT << "Py_DECREF(anonEnumItem);" << endl;
                 }
@@ -3223,17 +3342,17 @@ void CppGenerator::writeEnumInitialization(QTextStream& s, const AbstractMetaEnu
                 s << enumValueText << ") < 0)" << endl;
                 {
                     Indentation indent(INDENT);
-                    s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+                    s << INDENT << "return " << currentErrorCode() << ';' << endl;
                 }
             }
         } else {
             s << INDENT << "if (!Shiboken::Enum::";
             s << ((enclosingClass || hasUpperEnclosingClass) ? "createScopedEnumItem" : "createGlobalEnumItem");
-            s << '(' << cpythonTypeNameExt(cppEnum->typeEntry()) << ',' << endl;
+            s << '(' << cpythonTypeSlot(cppEnum->typeEntry()) << ',' << endl;
             Indentation indent(INDENT);
             s << INDENT << enclosingObjectVariable << ", \"" << enumValue->name() << "\", ";
             s << enumValueText << "))" << endl;
-            s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+            s << INDENT << "return " << currentErrorCode() << ';' << endl;
         }
     }
 
@@ -3255,7 +3374,7 @@ void CppGenerator::writeSignalInitialization(QTextStream& s, const AbstractMetaC
             QByteArray origType = SBK_NORMALIZED_TYPE(qPrintable(metaType->originalTypeDescription()));
             QByteArray cppSig = SBK_NORMALIZED_TYPE(qPrintable(metaType->cppSignature()));
             if ((origType != cppSig) && (!metaType->isFlags()))
-                ReportHandler::warning("Typedef used on signal " + metaClass->qualifiedCppName() + "::" + cppSignal->signature());
+                ShibokenGenerator::warning("Typedef used on signal " + metaClass->qualifiedCppName() + "::" + cppSignal->signature());
         }
     }
 
@@ -3458,18 +3577,9 @@ void CppGenerator::writeFlagsUnaryOperator(QTextStream& s, const AbstractMetaEnu
     s << '}' << endl << endl;
 }
 
-void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* metaClass)
+void CppGenerator::writeTypeProtocolsInitialization(QTextStream& s, const AbstractMetaClass* metaClass)
 {
-    const ComplexTypeEntry* classTypeEntry = metaClass->typeEntry();
-
-    const AbstractMetaClass* enc = metaClass->enclosingClass();
-    bool hasEnclosingClass = enc && enc->typeEntry()->codeGeneration() != TypeEntry::GenerateForSubclass;
-    QString enclosingObjectVariable = hasEnclosingClass ? "enclosingClass" : "module";
-
     QString pyTypeName = cpythonTypeName(metaClass);
-    s << "void init_" << metaClass->qualifiedCppName().replace("::", "_");
-    s << "(PyObject* " << enclosingObjectVariable << ")" << endl;
-    s << '{' << endl;
 
     if (supportsNumberProtocol(metaClass)) {
         s << INDENT << "// type has number operators" << endl;
@@ -3491,8 +3601,29 @@ void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* m
         s << INDENT << pyTypeName << ".super.ht_type.tp_as_mapping = &" << pyTypeName << ".super.as_mapping;" << endl;
         s << endl;
     }
+}
+
+QString CppGenerator::cppDestructorFunction(const AbstractMetaClass* metaClass)
+{
+    if (metaClass->isNamespace() || metaClass->hasPrivateDestructor())
+        return QString();
+    QString dtorClassName = metaClass->qualifiedCppName();
+    if ((avoidProtectedHack() && metaClass->hasProtectedDestructor()) || metaClass->typeEntry()->isValue())
+        dtorClassName = wrapperName(metaClass);
+    return "&Shiboken::callCppDestructor< ::" + dtorClassName + " >";
+}
 
-    s << INDENT << cpythonTypeNameExt(classTypeEntry);
+void CppGenerator::writeWrapperTypeIntroduction(QTextStream& s, const AbstractMetaClass* metaClass)
+{
+    const ComplexTypeEntry* classTypeEntry = metaClass->typeEntry();
+    const AbstractMetaClass* enc = metaClass->enclosingClass();
+    bool hasEnclosingClass = enc && enc->typeEntry()->codeGeneration() != TypeEntry::GenerateForSubclass;
+    QString enclosingObjectVariable = hasEnclosingClass ? "enclosingClass" : "module";
+    QString pyTypeName = cpythonTypeName(metaClass);
+
+    writeTypeProtocolsInitialization(s, metaClass);
+
+    s << INDENT << cpythonTypeSlot(classTypeEntry);
     s << " = reinterpret_cast<PyTypeObject*>(&" << pyTypeName << ");" << endl;
     s << endl;
 
@@ -3522,12 +3653,10 @@ void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* m
         s << INDENT << "&" << pyTypeName;
 
         // Set destructor function
-        if (!metaClass->isNamespace() && !metaClass->hasPrivateDestructor()) {
-            QString dtorClassName = metaClass->qualifiedCppName();
-            if ((avoidProtectedHack() && metaClass->hasProtectedDestructor()) || classTypeEntry->isValue())
-                dtorClassName = wrapperName(metaClass);
-            s << ", &Shiboken::callCppDestructor< ::" << dtorClassName << " >";
-        } else if (metaClass->baseClass() || hasEnclosingClass) {
+        QString dtor = cppDestructorFunction(metaClass);
+        if (!dtor.isEmpty())
+            s << ", " << dtor;
+        else if (metaClass->baseClass() || hasEnclosingClass) {
             s << ", 0";
         }
 
@@ -3548,6 +3677,37 @@ void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* m
         s << INDENT << "return;" << endl;
     }
     s << INDENT << '}' << endl << endl;
+}
+
+void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* metaClass)
+{
+    const ComplexTypeEntry* classTypeEntry = metaClass->typeEntry();
+
+    const AbstractMetaClass* enc = metaClass->enclosingClass();
+    bool hasEnclosingClass = enc && enc->typeEntry()->codeGeneration() != TypeEntry::GenerateForSubclass;
+    QString enclosingObjectVariable = hasEnclosingClass ? "enclosingClass" : "module";
+
+    QString pyTypeName = cpythonTypeName(metaClass);
+    bool hasProtocols = supportsNumberProtocol(metaClass) || supportsSequenceProtocol(metaClass)
+                        || supportsMappingProtocol(metaClass);
+
+    // With registration tables the type is introduced by libshiboken from its description,
+    // the init function only does what can't be described by data.
+    if (useTypeRegistrationTables()) {
+        if (hasProtocols) {
+            s << "static void " << cpythonBaseName(metaClass) << "_prepare()" << endl;
+            s << '{' << endl;
+            writeTypeProtocolsInitialization(s, metaClass);
+            s << '}' << endl << endl;
+        }
+        s << "static ";
+    }
+    s << "void init_" << metaClass->qualifiedCppName().replace("::", "_");
+    s << "(PyObject* " << enclosingObjectVariable << ")" << endl;
+    s << '{' << endl;
+
+    if (!useTypeRegistrationTables())
+        writeWrapperTypeIntroduction(s, metaClass);
 
     // class inject-code target/beginning
     if (!classTypeEntry->codeSnips().isEmpty()) {
@@ -3557,7 +3717,7 @@ void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* m
 
     // Fill multiple inheritance data, if needed.
     const AbstractMetaClass* miClass = getMultipleInheritingClass(metaClass);
-    if (miClass) {
+    if (miClass && !useTypeRegistrationTables()) {
         s << INDENT << "MultipleInheritanceInitFunction func = ";
         if (miClass == metaClass) {
             s << multipleInheritanceInitializerFunctionName(miClass) << ";" << endl;
@@ -3572,7 +3732,7 @@ void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* m
     }
 
     // Set typediscovery struct or fill the struct of another one
-    if (metaClass->isPolymorphic() && metaClass->baseClass()) {
+    if (metaClass->isPolymorphic() && metaClass->baseClass() && !useTypeRegistrationTables()) {
         s << INDENT << "Shiboken::ObjectType::setTypeDiscoveryFunctionV2(&" << cpythonTypeName(metaClass);
         s << ", &" << cpythonBaseName(metaClass) << "_typeDiscovery);" << endl << endl;
     }
@@ -3621,6 +3781,85 @@ void CppGenerator::writeClassRegister(QTextStream& s, const AbstractMetaClass* m
     }
 
     s << '}' << endl;
+
+    if (useTypeRegistrationTables()) {
+        s << endl;
+        writeTypeDescription(s, metaClass);
+    }
+}
+
+QString CppGenerator::typeReference(const TypeEntry* type)
+{
+    if (!type)
+        return "{ 0, 0 }";
+    return "{ &" + cppApiVariableName(type->targetLangPackage()) + ", " + getTypeIndexVariableName(type) + " }";
+}
+
+void CppGenerator::writeTypeDescription(QTextStream& s, const AbstractMetaClass* metaClass)
+{
+    const ComplexTypeEntry* classTypeEntry = metaClass->typeEntry();
+    const AbstractMetaClass* enc = metaClass->enclosingClass();
+    bool hasEnclosingClass = enc && enc->typeEntry()->codeGeneration() != TypeEntry::GenerateForSubclass;
+
+    QString baseTypesVariable;
+    if (metaClass->baseClassNames().size() > 1) {
+        baseTypesVariable = cpythonBaseName(metaClass) + "_BaseTypes";
+        s << "static const Shiboken::ObjectType::TypeReference " << baseTypesVariable << "[] = {" << endl;
+        {
+            Indentation indent(INDENT);
+            foreach (const AbstractMetaClass* base, getBaseClasses(metaClass))
+                s << INDENT << typeReference(base->typeEntry()) << ',' << endl;
+            s << INDENT << typeReference(0) << endl;
+        }
+        s << "};" << endl << endl;
+    }
+
+    QString dtor = cppDestructorFunction(metaClass);
+    const AbstractMetaClass* miClass = getMultipleInheritingClass(metaClass);
+    bool hasTypeDiscovery = metaClass->isPolymorphic() && metaClass->baseClass();
+
+    s << "extern const Shiboken::ObjectType::TypeDescription " << typeDescriptionVariableName(metaClass) << " = {" << endl;
+    {
+        Indentation indent(INDENT);
+        s << INDENT << '"' << metaClass->name() << "\", \"" << metaClass->qualifiedCppName();
+        s << (ShibokenGenerator::isObjectType(classTypeEntry) ?  "*" : "") << "\"," << endl;
+        s << INDENT << '&' << cpythonTypeName(metaClass) << ", " << getTypeIndexVariableName(classTypeEntry) << ',' << endl;
+        s << INDENT << "/* enclosingType */ " << typeReference(hasEnclosingClass ? enc->typeEntry() : 0) << ',' << endl;
+        s << INDENT << "/* cppObjDtor */ " << (dtor.isEmpty() ? "0" : dtor) << ',' << endl;
+        s << INDENT << "/* baseType */ " << typeReference(metaClass->baseClass() ? metaClass->baseClass()->typeEntry() : 0);
+        s << ", " << (baseTypesVariable.isEmpty() ? "0" : baseTypesVariable) << ',' << endl;
+        s << INDENT << "/* prepare */ ";
+        if (supportsNumberProtocol(metaClass) || supportsSequenceProtocol(metaClass) || supportsMappingProtocol(metaClass))
+            s << '&' << cpythonBaseName(metaClass) << "_prepare";
+        else
+            s << '0';
+        s << ',' << endl;
+        s << INDENT << "/* mi_init */ ";
+        if (miClass == metaClass)
+            s << multipleInheritanceInitializerFunctionName(miClass) << ", " << typeReference(0);
+        else
+            s << "0, " << typeReference(miClass ? miClass->typeEntry() : 0);
+        s << ',' << endl;
+        s << INDENT << "/* castFunction */ ";
+        if (miClass)
+            s << '&' << cpythonSpecialCastFunctionName(metaClass);
+        else
+            s << '0';
+        s << ',' << endl;
+        s << INDENT << "/* typeDiscovery */ ";
+        if (hasTypeDiscovery)
+            s << '&' << cpythonBaseName(metaClass) << "_typeDiscovery";
+        else
+            s << '0';
+        s << ',' << endl;
+        s << INDENT << "/* finish */ &init_" << metaClass->qualifiedCppName().replace("::", "_") << endl;
+    }
+    s << "};" << endl;
+}
+
+QString CppGenerator::typeDescriptionVariableName(const AbstractMetaClass* metaClass)
+{
+    return cpythonBaseName(metaClass) + "_TypeDescription";
 }
 
 void CppGenerator::writeInitQtMetaTypeFunctionBody(QTextStream& s, const AbstractMetaClass* metaClass) const
@@ -3693,7 +3932,7 @@ void CppGenerator::writeTypeDiscoveryFunction(QTextStream& s, const AbstractMeta
                 s << INDENT << "return dynamic_cast< ::" << metaClass->qualifiedCppName()
                             << "*>(reinterpret_cast< ::"<< ancestor->qualifiedCppName() << "*>(cptr));" << endl;
             } else {
-                ReportHandler::warning(metaClass->qualifiedCppName() + " inherits from a non polymorphic type ("
+                ShibokenGenerator::warning(metaClass->qualifiedCppName() + " inherits from a non polymorphic type ("
                                        + ancestor->qualifiedCppName() + "), type discovery based on RTTI is "
                                        "impossible, write a polymorphic-id-expression for this type.");
             }
@@ -3816,13 +4055,27 @@ void CppGenerator::finishGeneration()
         lst.insert(indexOf, klassQMetaObject);
     }
 
+    QStringList typeDescriptions;
     foreach (const AbstractMetaClass* cls, lst) {
         if (!shouldGenerate(cls))
             continue;
 
+        if (useTypeRegistrationTables()) {
+            s_classInitDecl << "extern const Shiboken::ObjectType::TypeDescription " << typeDescriptionVariableName(cls) << ';' << endl;
+            typeDescriptions << '&' + typeDescriptionVariableName(cls);
+            continue;
+        }
+
         s_classInitDecl << "void init_" << cls->qualifiedCppName().replace("::", "_") << "(PyObject* module);" << endl;
 
+        if (useLazyTypeInit()) {
+            writeLazyTypeRegistration(s_classPythonDefines, cls);
+            continue;
+        }
+
         QString defineStr = "init_" + cls->qualifiedCppName().replace("::", "_");
+        if (useStartupProfile())
+            writeInitTimerStep(s_classPythonDefines, defineStr);
 
         if (cls->enclosingClass() && (cls->enclosingClass()->typeEntry()->codeGeneration() != TypeEntry::GenerateForSubclass))
             defineStr += "(" + cpythonTypeNameExt(cls->enclosingClass()->typeEntry()) +"->tp_dict);";
@@ -3834,18 +4087,16 @@ void CppGenerator::finishGeneration()
     QString moduleFileName(outputDirectory() + "/" + subDirectoryForPackage(packageName()));
     moduleFileName += "/" + moduleName().toLower() + "_module_wrapper.cpp";
 
-    QFile file(moduleFileName);
-    verifyDirectoryFor(file);
-    if (!file.open(QFile::WriteOnly)) {
-        ReportHandler::warning("Error writing file: " + moduleFileName);
-        return;
-    }
-
-    QTextStream s(&file);
+    // FileOut only touches the file when the generated code differs from its current contents.
+    FileOut file(moduleFileName);
+    QTextStream& s = file.stream;
 
     // write license comment
     s << licenseComment() << endl;
 
+    if (useSharedConverters())
+        s << "#define " << sharedConvertersMacro() << endl << endl;
+
     s << "#include <sbkpython.h>" << endl;
     s << "#include <shiboken.h>" << endl;
     s << "#include <algorithm>" << endl;
@@ -3916,6 +4167,19 @@ void CppGenerator::finishGeneration()
     s << globalFunctionDecl;
     s << INDENT << "{0} // Sentinel" << endl << "};" << endl << endl;
 
+    if (useSharedConverters()) {
+        // The only definitions of the module types converters, declared in the module header.
+        s << "// Converters ";
+        s << "------------------------------------------------------------" << endl;
+        foreach (const AbstractMetaClass* metaClass, classes()) {
+            if (!shouldGenerate(metaClass) || metaClass->isNamespace())
+                continue;
+            writeTypeConverterImpl(s, metaClass->typeEntry(), false);
+            writeSharedConverterImpl(s, metaClass->typeEntry());
+        }
+        s << endl;
+    }
+
     s << "// Classes initialization functions ";
     s << "------------------------------------------------------------" << endl;
     s << classInitDecl << endl;
@@ -4004,7 +4268,12 @@ void CppGenerator::finishGeneration()
         s << endl;
     }
 
+    if (useStartupProfile())
+        s << INDENT << "Shiboken::Module::InitTimer initTimer(\"" << moduleName() << "\");" << endl << endl;
+
     foreach (const QString& requiredModule, typeDb->requiredTargetImports()) {
+        if (useStartupProfile())
+            writeInitTimerStep(s, "import " + requiredModule);
         s << INDENT << "{" << endl;
         {
             Indentation indentation(INDENT);
@@ -4014,11 +4283,14 @@ void CppGenerator::finishGeneration()
                 Indentation indentation(INDENT);
                 s << INDENT << "SBK_MODULE_INIT_ERROR;" << endl;
             }
-            s << INDENT << cppApiVariableName(requiredModule) << " = Shiboken::Module::getTypes(requiredModule);" << endl;
+            s << INDENT << cppApiVariableName(requiredModule) << " = Shiboken::Module::";
+            s << (useLazyTypeInit() ? "getLazyTypes" : "getTypes") << "(requiredModule);" << endl;
         }
         s << INDENT << "}" << endl << endl;
     }
 
+    if (useStartupProfile())
+        writeInitTimerStep(s, "create module");
     s << INDENT << "// Create an array of wrapper types for the current module." << endl;
     s << INDENT << "static PyTypeObject* cppApi[" << "SBK_" << moduleName() << "_IDX_COUNT" << "];" << endl;
     s << INDENT << cppApiVariableName() << " = cppApi;" << endl << endl;
@@ -4031,9 +4303,30 @@ void CppGenerator::finishGeneration()
     s << "#endif" << endl << endl;
 
     s << INDENT << "// Initialize classes in the type system" << endl;
+    if (useStartupProfile() && useLazyTypeInit())
+        writeInitTimerStep(s, "lazy type registration");
     s << classPythonDefines;
+    if (!typeDescriptions.isEmpty()) {
+        s << INDENT << "static const Shiboken::ObjectType::TypeDescription* const typeDescriptions[] = {" << endl;
+        {
+            Indentation indent(INDENT);
+            foreach (const QString& typeDescription, typeDescriptions)
+                s << INDENT << typeDescription << ',' << endl;
+        }
+        s << INDENT << "};" << endl;
+        if (useStartupProfile())
+            writeInitTimerStep(s, "introduceWrapperTypes");
+        s << INDENT << "if (!Shiboken::ObjectType::introduceWrapperTypes(module, cppApi, typeDescriptions, ";
+        s << typeDescriptions.size() << "))" << endl;
+        {
+            Indentation indent(INDENT);
+            s << INDENT << "return " << currentErrorCode() << ';' << endl;
+        }
+    }
 
     if (!extendedConverters.isEmpty()) {
+        if (useStartupProfile())
+            writeInitTimerStep(s, "extended converters");
         s << INDENT << "// Initialize extended Converters" << endl;
         s << INDENT << "SbkObjectType* shiboType;" << endl << endl;
     }
@@ -4043,9 +4336,11 @@ void CppGenerator::finishGeneration()
     }
     s << endl;
 
-    writeEnumsInitialization(s, globalEnums);
+    writeEnumsInitialization(s, globalEnums, useStartupProfile());
 
     // Register primitive types on TypeResolver
+    if (useStartupProfile())
+        writeInitTimerStep(s, "type resolvers");
     s << INDENT << "// Register primitive types on TypeResolver" << endl;
     foreach(const PrimitiveTypeEntry* pte, primitiveTypes()) {
         if (pte->generateCode())
@@ -4072,7 +4367,10 @@ void CppGenerator::finishGeneration()
     foreach (QByteArray type, typeResolvers)
         s << INDENT << typeResolverString(type) << ';' << endl;
 
-    s << endl << INDENT << "Shiboken::Module::registerTypes(module, " << cppApiVariableName() << ");" << endl;
+    s << endl;
+    if (useStartupProfile())
+        writeInitTimerStep(s, "registerTypes");
+    s << INDENT << "Shiboken::Module::registerTypes(module, " << cppApiVariableName() << ");" << endl;
 
     s << endl << INDENT << "if (PyErr_Occurred()) {" << endl;
     {
@@ -4081,6 +4379,8 @@ void CppGenerator::finishGeneration()
         s << INDENT << "Py_FatalError(\"can't initialize module " << moduleName() << "\");" << endl;
     }
     s << INDENT << '}' << endl;
+    if (useStartupProfile())
+        s << INDENT << "initTimer.finish();" << endl;
 
     // module inject-code target/end
     if (!snips.isEmpty()) {
@@ -4105,6 +4405,93 @@ void CppGenerator::finishGeneration()
     }
 
     s << "SBK_MODULE_INIT_FUNCTION_END" << endl;
+
+    if (unityBuildFiles() > 0)
+        writeUnityBuildFiles();
+
+    reportOverloadDataStatistics();
+    writeClassFingerprints();
+}
+
+void CppGenerator::writeInitTimerStep(QTextStream& s, const QString& step)
+{
+    s << INDENT << "initTimer.step(\"" << step << "\");" << endl;
+}
+
+void CppGenerator::writeUnityBuildFiles()
+{
+    QString packageDirectory = outputDirectory() + '/' + subDirectoryForPackage(packageName());
+
+    // The biggest wrappers are distributed first, each one to the unity file with less code.
+    QList<QPair<qint64, QString> > wrappers;
+    foreach (const AbstractMetaClass* metaClass, classes()) {
+        if (!shouldGenerate(metaClass) || fileNameForClass(metaClass).isNull())
+            continue;
+        QString fileName = outputDirectory() + '/' + subDirectoryForClass(metaClass) + '/' + fileNameForClass(metaClass);
+        wrappers << qMakePair(QFileInfo(fileName).size(), QDir(packageDirectory).relativeFilePath(fileName));
+    }
+    qSort(wrappers.begin(), wrappers.end(), qGreater<QPair<qint64, QString> >());
+
+    QVector<qint64> unitSizes(unityBuildFiles(), 0);
+    QVector<QStringList> units(unityBuildFiles());
+    for (int i = 0; i < wrappers.size(); ++i) {
+        int smallest = 0;
+        for (int unit = 1; unit < unitSizes.size(); ++unit) {
+            if (unitSizes[unit] < unitSizes[smallest])
+                smallest = unit;
+        }
+        unitSizes[smallest] += wrappers[i].first;
+        units[smallest] << wrappers[i].second;
+    }
+
+    for (int unit = 0; unit < units.size(); ++unit) {
+        QString fileName = QString("%1/%2_unity_%3.cpp").arg(packageDirectory).arg(moduleName().toLower()).arg(unit);
+        FileOut file(fileName);
+        QTextStream& s = file.stream;
+        s << licenseComment() << endl;
+        s << "// Unity build file " << unit << ", " << unitSizes[unit] << " bytes of wrapper code" << endl << endl;
+        units[unit].sort();
+        foreach (const QString& wrapper, units[unit])
+            s << "#include \"" << wrapper << '"' << endl;
+    }
+}
+
+void CppGenerator::writeLazyTypeRegistration(QTextStream& s, const AbstractMetaClass* metaClass)
+{
+    QString initFunction = "init_" + metaClass->qualifiedCppName().replace("::", "_");
+    QString typeIndex = getTypeIndexVariableName(metaClass->typeEntry());
+    const AbstractMetaClass* enc = metaClass->enclosingClass();
+    bool hasEnclosingClass = enc && enc->typeEntry()->codeGeneration() != TypeEntry::GenerateForSubclass;
+
+    s << INDENT << "Shiboken::Module::registerLazyType(module, " << cppApiVariableName() << ", ";
+    if (hasEnclosingClass) {
+        s << "0, " << typeIndex << ", " << initFunction << ", ";
+        s << getTypeIndexVariableName(enc->typeEntry()) << ");" << endl;
+    } else {
+        s << '"' << metaClass->name() << "\", " << typeIndex << ", " << initFunction << ");" << endl;
+    }
+
+    // Type discovery on instances of the base classes must find this type even before its first use.
+    foreach (const AbstractMetaClass* base, getBaseClasses(metaClass)) {
+        s << INDENT << "Shiboken::Module::registerLazySubType(" << cppApiVariableName(base->typeEntry()->targetLangPackage()) << ", ";
+        s << getTypeIndexVariableName(base->typeEntry()) << ", " << cppApiVariableName() << ", " << typeIndex << ");" << endl;
+    }
+
+    // Enums are created along with the class, the same way writeClassRegister finds them.
+    AbstractMetaEnumList classEnums = metaClass->enums();
+    foreach (AbstractMetaClass* innerClass, metaClass->innerClasses())
+        lookForEnumsInClassesNotToBeGenerated(classEnums, innerClass);
+    foreach (const AbstractMetaEnum* cppEnum, classEnums) {
+        if (cppEnum->isPrivate() || cppEnum->isAnonymous())
+            continue;
+        s << INDENT << "Shiboken::Module::registerLazyTypeIndex(" << cppApiVariableName() << ", ";
+        s << getTypeIndexVariableName(cppEnum->typeEntry()) << ", " << typeIndex << ");" << endl;
+        FlagsTypeEntry* flags = cppEnum->typeEntry()->flags();
+        if (flags) {
+            s << INDENT << "Shiboken::Module::registerLazyTypeIndex(" << cppApiVariableName() << ", ";
+            s << getTypeIndexVariableName(flags) << ", " << typeIndex << ");" << endl;
+        }
+    }
 }
 
 static ArgumentOwner getArgumentOwner(const AbstractMetaFunction* func, int argIndex)
@@ -4120,7 +4507,7 @@ bool CppGenerator::writeParentChildManagement(QTextStream& s, const AbstractMeta
     const int numArgs = func->arguments().count();
     bool ctorHeuristicEnabled = func->isConstructor() && useCtorHeuristic() && useHeuristicPolicy;
 
-    bool usePyArgs = pythonFunctionWrapperUsesListOfArguments(OverloadData(getFunctionGroups(func->implementingClass())[func->name()], this));
+    bool usePyArgs = pythonFunctionWrapperUsesListOfArguments(getOverloadData(func));
 
     ArgumentOwner argOwner = getArgumentOwner(func, argIndex);
     ArgumentOwner::Action action = argOwner.action;
@@ -4139,7 +4526,7 @@ bool CppGenerator::writeParentChildManagement(QTextStream& s, const AbstractMeta
     QString childVariable;
     if (action != ArgumentOwner::Invalid) {
         if (!usePyArgs && argIndex > 1)
-            ReportHandler::warning("Argument index for parent tag out of bounds: "+func->signature());
+            ShibokenGenerator::warning("Argument index for parent tag out of bounds: "+func->signature());
 
         if (action == ArgumentOwner::Remove) {
             parentVariable = "Py_None";
@@ -4247,7 +4634,7 @@ void CppGenerator::writeIndexError(QTextStream& s, const QString& errorMsg)
     {
         Indentation indent(INDENT);
         s << INDENT << "PyErr_SetString(PyExc_IndexError, \"" << errorMsg << "\");" << endl;
-        s << INDENT << "return " << m_currentErrorCode << ';' << endl;
+        s << INDENT << "return " << currentErrorCode() << ';' << endl;
     }
     s << INDENT << '}' << endl;
 }
@@ -55,6 +55,12 @@ private:
     void writeConstructorWrapper(QTextStream& s, const AbstractMetaFunctionList overloads);
     void writeDestructorWrapper(QTextStream& s, const AbstractMetaClass* metaClass);
     void writeMethodWrapper(QTextStream& s, const AbstractMetaFunctionList overloads);
+    /// Writes the call counters of a function named \p name, and the timer measuring the current call.
+    void writeCallTimer(QTextStream& s, const QString& name, int overloadCount = 1);
+    /// Returns true if the methods in \p overloads release the GIL and get an "_async" variant.
+    bool hasAsyncVariant(const AbstractMetaFunctionList& overloads) const;
+    /// Writes the "_async" variant of a method, which runs it on a libshiboken worker thread.
+    void writeAsyncMethodWrapper(QTextStream& s, const AbstractMetaFunctionList overloads);
     void writeArgumentsInitializer(QTextStream& s, OverloadData& overloadData);
     void writeCppSelfDefinition(QTextStream& s, const AbstractMetaFunction* func, bool hasStaticOverload = false);
     void writeCppSelfDefinition(QTextStream& s, const AbstractMetaClass* metaClass, bool hasStaticOverload = false, bool cppSelfAsReference = false);
@@ -149,9 +155,27 @@ private:
     void writeMethodCall(QTextStream& s, const AbstractMetaFunction* func, int maxArgs = 0);
 
     void writeClassRegister(QTextStream& s, const AbstractMetaClass* metaClass);
+    /// Writes the setup of the number, sequence and mapping protocols of \p metaClass type.
+    void writeTypeProtocolsInitialization(QTextStream& s, const AbstractMetaClass* metaClass);
+    /// Writes the code that readies \p metaClass type and adds it to the module or enclosing class.
+    void writeWrapperTypeIntroduction(QTextStream& s, const AbstractMetaClass* metaClass);
+    /// Writes the constant description of \p metaClass type used by the module's registration table.
+    void writeTypeDescription(QTextStream& s, const AbstractMetaClass* metaClass);
+    QString typeDescriptionVariableName(const AbstractMetaClass* metaClass);
+    /// Returns the initializer of a Shiboken::ObjectType::TypeReference to \p type, or an empty one if \p type is null.
+    QString typeReference(const TypeEntry* type);
+    /// Returns the address of the C++ destructor function for \p metaClass, or an empty string if it has none.
+    QString cppDestructorFunction(const AbstractMetaClass* metaClass);
+    /// Writes the module init code that registers \p metaClass to be initialized on its first use.
+    void writeLazyTypeRegistration(QTextStream& s, const AbstractMetaClass* metaClass);
+    /// Writes the unity build files, each one including a share of the class wrappers with about the same size.
+    void writeUnityBuildFiles();
+    /// Writes the start of the module initialization \p step measured by the startup profile.
+    void writeInitTimerStep(QTextStream& s, const QString& step);
     void writeClassDefinition(QTextStream& s, const AbstractMetaClass* metaClass);
     void writeMethodDefinitionEntry(QTextStream& s, const AbstractMetaFunctionList overloads);
     void writeMethodDefinition(QTextStream& s, const AbstractMetaFunctionList overloads);
+    void writeAsyncMethodDefinition(QTextStream& s, const AbstractMetaFunctionList overloads);
 
     /// Writes the implementation of all methods part of python sequence protocol
     void writeSequenceMethods(QTextStream& s, const AbstractMetaClass* metaClass);
@@ -174,7 +198,8 @@ private:
     void writeRichCompareFunction(QTextStream& s, const AbstractMetaClass* metaClass);
     void writeToPythonFunction(QTextStream& s, const AbstractMetaClass* metaClass);
 
-    void writeEnumsInitialization(QTextStream& s, AbstractMetaEnumList& enums);
+    /// Writes the creation of \p enums, each one timed as a step of the module initialization if \p timeSteps is true.
+    void writeEnumsInitialization(QTextStream& s, AbstractMetaEnumList& enums, bool timeSteps = false);
     void writeEnumInitialization(QTextStream& s, const AbstractMetaEnum* metaEnum);
 
     void writeSignalInitialization(QTextStream& s, const AbstractMetaClass* metaClass);
@@ -254,21 +279,22 @@ private:
     // Mapping protocol structure members names.
     static QHash<QString, QString> m_mpFuncs;
 
-    static QString m_currentErrorCode;
+    /// Returns the error code of the code being generated by the current thread.
+    static QString& currentErrorCode();
 
     /// Helper class to set and restore the current error code.
     class ErrorCode {
     public:
         explicit ErrorCode(QString errorCode) {
-            m_savedErrorCode = CppGenerator::m_currentErrorCode;
-            CppGenerator::m_currentErrorCode = errorCode;
+            m_savedErrorCode = CppGenerator::currentErrorCode();
+            CppGenerator::currentErrorCode() = errorCode;
         }
         explicit ErrorCode(int errorCode) {
-            m_savedErrorCode = CppGenerator::m_currentErrorCode;
-            CppGenerator::m_currentErrorCode = QString::number(errorCode);
+            m_savedErrorCode = CppGenerator::currentErrorCode();
+            CppGenerator::currentErrorCode() = QString::number(errorCode);
         }
         ~ErrorCode() {
-            CppGenerator::m_currentErrorCode = m_savedErrorCode;
+            CppGenerator::currentErrorCode() = m_savedErrorCode;
         }
     private:
         QString m_savedErrorCode;
@@ -27,6 +27,7 @@
 #include <fileout.h>
 
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 #include <QtCore/QTextStream>
 #include <QtCore/QVariant>
 #include <QtCore/QRegExp>
@@ -72,8 +73,11 @@ void HeaderGenerator::writeProtectedFieldAccessors(QTextStream& s, const Abstrac
 
 void HeaderGenerator::generateClass(QTextStream& s, const AbstractMetaClass* metaClass)
 {
-    ReportHandler::debugSparse("Generating header for " + metaClass->fullName());
-    m_inheritedOverloads.clear();
+    if (writeUnchangedClassCode(s, metaClass) || writeCodeGeneratedInParallel(s, metaClass))
+        return;
+
+    ShibokenGenerator::debugSparse("Generating header for " + metaClass->fullName());
+    StatisticsCollector statistics(s, metaClass);
     Indentation indent(INDENT);
 
     // write license comment
@@ -106,10 +110,11 @@ void HeaderGenerator::generateClass(QTextStream& s, const AbstractMetaClass* met
         s << endl << '{' << endl << "public:" << endl;
 
         bool hasVirtualFunction = false;
+        QSet<const AbstractMetaFunction*> inheritedOverloads;
         foreach (AbstractMetaFunction *func, filterFunctions(metaClass)) {
             if (func->isVirtual())
                 hasVirtualFunction = true;
-            writeFunction(s, func);
+            writeFunction(s, func, inheritedOverloads);
         }
 
         if (avoidProtectedHack() && metaClass->hasProtectedFields()) {
@@ -137,9 +142,9 @@ void HeaderGenerator::generateClass(QTextStream& s, const AbstractMetaClass* met
             s << INDENT << "virtual void* qt_metacast(const char* _clname);" << endl;
         }
 
-        if (m_inheritedOverloads.size()) {
+        if (inheritedOverloads.size()) {
             s << INDENT << "// Inherited overloads, because the using keyword sux" << endl;
-            writeInheritedOverloads(s);
+            writeInheritedOverloads(s, inheritedOverloads);
         }
 
         if (usePySideExtensions())
@@ -151,7 +156,7 @@ void HeaderGenerator::generateClass(QTextStream& s, const AbstractMetaClass* met
     s << "#endif // SBK_" << headerGuard << "_H" << endl << endl;
 }
 
-void HeaderGenerator::writeFunction(QTextStream& s, const AbstractMetaFunction* func)
+void HeaderGenerator::writeFunction(QTextStream& s, const AbstractMetaFunction* func, QSet<const AbstractMetaFunction*>& inheritedOverloads)
 {
 
     // do not write copy ctors here.
@@ -214,7 +219,7 @@ void HeaderGenerator::writeFunction(QTextStream& s, const AbstractMetaFunction*
                 && !f->isAbstract()
                 && !f->isStatic()
                 && f->name() == func->name()) {
-                m_inheritedOverloads << f;
+                inheritedOverloads << f;
                 break;
             }
         }
@@ -276,6 +281,24 @@ void HeaderGenerator::writeTypeConverterDecl(QTextStream& s, const TypeEntry* ty
             s << INDENT << "static PyObject* toPython(const " << typeName << "& cppObj);" << endl;
         }
     }
+    if (hasSharedConverter(type)) {
+        // Defined in the module source file, other modules use the inherited inline functions.
+        s << "#ifdef " << sharedConvertersMacro() << endl;
+        if (isAbstractOrObjectType) {
+            s << INDENT << "using ObjectTypeConverter< " << typeName << " >::toPython;" << endl;
+            s << INDENT << "static PyObject* toPython(const " << typeName << "* cppobj);" << endl;
+            s << INDENT << "static " << typeName << "* toCpp(PyObject* pyobj);" << endl;
+        } else {
+            s << INDENT << "using ValueTypeConverter< " << typeName << " >::toPython;" << endl;
+            s << INDENT << "static PyObject* toPython(const " << typeName << "& cppobj);" << endl;
+            s << "#ifdef SBK_HAS_RVALUE_REFERENCES" << endl;
+            s << INDENT << "static PyObject* toPython(" << typeName << "&& cppobj);" << endl;
+            s << "#endif" << endl;
+            if (!isValueTypeWithImplConversions)
+                s << INDENT << "static " << typeName << " toCpp(PyObject* pyobj);" << endl;
+        }
+        s << "#endif" << endl;
+    }
     s << "};" << endl;
 
     // write value-type like converter to object-types
@@ -427,6 +450,8 @@ void HeaderGenerator::finishGeneration()
     s << "#include <sbkenum.h>" << endl;
     s << "#include <basewrapper.h>" << endl;
     s << "#include <bindingmanager.h>" << endl;
+    if (useLazyTypeInit())
+        s << "#include <sbkmodule.h>" << endl;
     s << "#include <memory>" << endl << endl;
     if (usePySideExtensions())
         s << "#include <pysidesignal.h>" << endl;
@@ -503,9 +528,20 @@ void HeaderGenerator::finishGeneration()
         }
     }
     s << "// Generated converters implemantations -------------------------------" << endl << endl;
-    s << converterImpl << endl;
+    if (useSharedConverters()) {
+        // The module source files use the ones defined in the module source file.
+        s << "#ifndef " << sharedConvertersMacro() << endl;
+        s << converterImpl;
+        s << "#endif" << endl << endl;
+    } else {
+        s << converterImpl << endl;
+    }
 
     s << "#endif // " << includeShield << endl << endl;
+
+    writeClassFingerprints();
+    writeCodeSizeReport();
+    writeStatistics();
 }
 
 void HeaderGenerator::writeProtectedEnumSurrogate(QTextStream& s, const AbstractMetaEnum* cppEnum)
@@ -541,111 +577,50 @@ void HeaderGenerator::writeSbkTypeFunction(QTextStream& s, const AbstractMetaCla
       <<  "{ return reinterpret_cast<PyTypeObject*>(" << cpythonTypeNameExt(cppClass->typeEntry()) << "); }\n";
 }
 
-void HeaderGenerator::writeTypeConverterImpl(QTextStream& s, const TypeEntry* type)
+void HeaderGenerator::writeCodeSizeReport()
 {
-    if (type->hasNativeConversionRule())
+    if (codeSizeReportFileName().isEmpty())
         return;
 
-    QString pyTypeName = cpythonTypeName(type);
-
-    AbstractMetaFunctionList implicitConvs;
-    foreach (AbstractMetaFunction* func, implicitConversions(type)) {
-        if (!func->isUserAdded())
-            implicitConvs << func;
-    }
-
-    bool hasImplicitConversions = !implicitConvs.isEmpty();
-
-    // A specialized Converter<T>::toCpp method is only need for
-    // classes with implicit conversions.
-    if (!hasImplicitConversions)
-        return;
-
-    const QString typeName = "::" + type->qualifiedCppName();
-
-    // Write Converter<T>::isConvertible
-    s << "inline bool Shiboken::Converter< " << typeName << " >::isConvertible(PyObject* pyobj)" << endl;
-    s << '{' << endl;
-
-    if (type->isValue()) {
-        s << INDENT << "if (ValueTypeConverter< " << typeName << " >::isConvertible(pyobj))" << endl;
-        Indentation indent(INDENT);
-        s << INDENT << "return true;" << endl;
-    }
-
-
-    s << INDENT << "SbkObjectType* shiboType = reinterpret_cast<SbkObjectType*>(SbkType< ";
-    s << typeName << " >());" << endl;
-    s << INDENT << "return ";
-    bool isFirst = true;
-    foreach (const AbstractMetaFunction* ctor, implicitConvs) {
-        Indentation indent(INDENT);
-        if (isFirst)
-            isFirst = false;
-        else
-            s << endl << INDENT << " || ";
-        if (ctor->isConversionOperator())
-            s << cpythonCheckFunction(ctor->ownerClass()->typeEntry());
-        else
-            s << cpythonCheckFunction(ctor->arguments().first()->type());
-        s << "(pyobj)";
-    }
-    s << endl;
-    {
-        Indentation indent(INDENT);
-        s << INDENT << " || (ObjectType::isExternalConvertible(shiboType, pyobj));" << endl;
-    }
-    s << '}' << endl << endl;
-
-    // Write Converter<T>::toCpp function
-    s << "inline " << typeName << " Shiboken::Converter< " << typeName << " >::toCpp(PyObject* pyobj)" << endl;
-    s << '{' << endl;
-
-    s << INDENT << "if (PyObject_TypeCheck(pyobj, SbkType< " << typeName << " >()))" << endl;
-    {
-        Indentation indent(INDENT);
-        s << INDENT << "return *" << cpythonWrapperCPtr(type, "pyobj") << ';' << endl;
-    }
-
-    foreach (const AbstractMetaFunction* ctor, implicitConvs) {
-        if (ctor->isModifiedRemoved())
+    QList<QPair<qint64, QString> > report;
+    qint64 total = 0;
+    foreach (const AbstractMetaClass* metaClass, classes()) {
+        if (!shouldGenerate(metaClass) || metaClass->isNamespace())
             continue;
-
-        s << INDENT << "else ";
-
-        QString typeCheck;
-        QString toCppConv;
-        QTextStream tcc(&toCppConv);
-        if (ctor->isConversionOperator()) {
-            const AbstractMetaClass* metaClass = ctor->ownerClass();
-            typeCheck = cpythonCheckFunction(metaClass->typeEntry());
-            writeToCppConversion(tcc, metaClass, "pyobj");
-        } else {
-            const AbstractMetaType* argType = ctor->arguments().first()->type();
-            typeCheck = cpythonCheckFunction(argType);
-            writeToCppConversion(tcc, argType, 0, "pyobj");
-        }
-
-        s << "if (" << typeCheck << "(pyobj))" << endl;
-        {
-            Indentation indent(INDENT);
-            s << INDENT << "return " << type->name() << '(' << toCppConv << ");" << endl;
-        }
-    }
-
-    {
-        s << INDENT << "else" << endl;
-        {
-            Indentation indent(INDENT);
-            s << INDENT << "return Shiboken::ValueTypeConverter< " << typeName << " >::toCpp(pyobj);" << endl;
-        }
+        // The source files were already written by the CppGenerator.
+        QString classDir = outputDirectory() + '/' + subDirectoryForClass(metaClass) + '/';
+        qint64 sourceSize = QFileInfo(classDir + fileNameForClassSource(metaClass)).size();
+        qint64 headerSize = QFileInfo(classDir + fileNameForClass(metaClass)).size();
+
+        QString converterCode;
+        QTextStream c(&converterCode);
+        writeTypeConverterDecl(c, metaClass->typeEntry());
+        writeTypeConverterImpl(c, metaClass->typeEntry());
+        writeSharedConverterImpl(c, metaClass->typeEntry());
+        c.flush();
+
+        qint64 size = sourceSize + headerSize + converterCode.toUtf8().size();
+        total += size;
+        report << qMakePair(size, QString("%1 %2 %3 %4").arg(metaClass->qualifiedCppName()).arg(sourceSize)
+                                                      .arg(headerSize).arg(converterCode.toUtf8().size()));
+    }
+    qSort(report);
+
+    QFile file(codeSizeReportFileName());
+    if (!file.open(QFile::WriteOnly)) {
+        ShibokenGenerator::warning("Error writing file: " + file.fileName());
+        return;
     }
-    s << '}' << endl << endl;
+    QTextStream s(&file);
+    s << "# Generated code size in bytes, biggest types last: type, source, header, converter" << endl;
+    for (int i = 0; i < report.size(); ++i)
+        s << report[i].second << endl;
+    s << "# Total: " << total << endl;
 }
 
-void HeaderGenerator::writeInheritedOverloads(QTextStream& s)
+void HeaderGenerator::writeInheritedOverloads(QTextStream& s, const QSet<const AbstractMetaFunction*>& inheritedOverloads)
 {
-    foreach (const AbstractMetaFunction* func, m_inheritedOverloads) {
+    foreach (const AbstractMetaFunction* func, inheritedOverloads) {
         s << INDENT << "inline ";
         s << functionSignature(func, "", "", Generator::EnumAsInts|Generator::OriginalTypeDescription) << " { ";
         s << (func->type() ? "return " : "");
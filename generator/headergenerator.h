@@ -41,17 +41,17 @@ protected:
 private:
     void writeCopyCtor(QTextStream &s, const AbstractMetaClass* metaClass) const;
     void writeProtectedFieldAccessors(QTextStream& s, const AbstractMetaField* field) const;
-    void writeFunction(QTextStream& s, const AbstractMetaFunction* func);
+    /// Writes the declaration of \p func, adding to \p inheritedOverloads the base class overloads it hides.
+    void writeFunction(QTextStream& s, const AbstractMetaFunction* func, QSet<const AbstractMetaFunction*>& inheritedOverloads);
     void writeTypeConverterDecl(QTextStream& s, const TypeEntry* type);
     void writeSbkTypeFunction(QTextStream& s, const AbstractMetaEnum* cppEnum);
     void writeSbkTypeFunction(QTextStream& s, const AbstractMetaClass* cppClass);
     void writeTypeIndexDefineLine(QTextStream& s, const TypeEntry* typeEntry);
     void writeTypeIndexDefine(QTextStream& s, const AbstractMetaClass* metaClass);
-    void writeTypeConverterImpl(QTextStream& s, const TypeEntry* type);
     void writeProtectedEnumSurrogate(QTextStream& s, const AbstractMetaEnum* cppEnum);
-    void writeInheritedOverloads(QTextStream& s);
-
-    QSet<const AbstractMetaFunction*> m_inheritedOverloads;
+    /// Writes the size of the code generated for each type to the file given by the "code-size-report" option.
+    void writeCodeSizeReport();
+    void writeInheritedOverloads(QTextStream& s, const QSet<const AbstractMetaFunction*>& inheritedOverloads);
 };
 
 #endif // HEADERGENERATOR_H
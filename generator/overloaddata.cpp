@@ -143,6 +143,26 @@ static QString getImplicitConversionTypeName(const AbstractMetaType* containerTy
     return containerTypeEntry->qualifiedCppName() + '<' + types.join(", ") + " >";
 }
 
+// Nodes of the sorting graph without OverloadData only express dependencies, they cost nothing.
+static int checkCostOf(const OverloadData* overloadData)
+{
+    return overloadData ? overloadData->checkCost() : OverloadData::TypeCheck;
+}
+
+static const char* checkCostName(OverloadData::CheckCost cost)
+{
+    switch (cost) {
+    case OverloadData::TypeCheck:
+        return "type";
+    case OverloadData::ConversionCheck:
+        return "conversion";
+    case OverloadData::SequenceCheck:
+        return "sequence";
+    default:
+        return "generic";
+    }
+}
+
 /**
  * Topologically sort the overloads by implicit convertion order
  *
@@ -395,17 +415,60 @@ void OverloadData::sortNextOverloads()
         for (; it != sortData.map.end(); ++it)
             nodeNames.insert(it.value(), it.key());
         graph.dumpDot(nodeNames, graphName);
-        ReportHandler::warning(QString("Cyclic dependency found on overloaddata for '%1' method! The graph boy saved the graph at %2.").arg(qPrintable(funcName)).arg(qPrintable(graphName)));
+        ShibokenGenerator::warning(QString("Cyclic dependency found on overloaddata for '%1' method! The graph boy saved the graph at %2.").arg(qPrintable(funcName)).arg(qPrintable(graphName)));
+    }
+
+    // The implicit conversions leave many types unordered, among them the cheapest checks go first.
+    // A type moves before its neighbour only if they aren't linked by an edge, so the order stays valid.
+    QList<int> costSortedResult;
+    foreach (int i, unmappedResult) {
+        int pos = costSortedResult.size();
+        while (pos > 0 && !graph.containsEdge(costSortedResult[pos - 1], i)
+               && checkCostOf(sortData.reverseMap[costSortedResult[pos - 1]]) > checkCostOf(sortData.reverseMap[i])) {
+            --pos;
+        }
+        costSortedResult.insert(pos, i);
     }
 
     m_nextOverloadData.clear();
-    foreach(int i, unmappedResult) {
+    foreach(int i, costSortedResult) {
         if (!sortData.reverseMap[i])
             continue;
         m_nextOverloadData << sortData.reverseMap[i];
     }
 }
 
+OverloadData::CheckCost OverloadData::checkCost() const
+{
+    QString typeName = getTypeName(this);
+    if (typeName.contains("PyObject"))
+        return GenericCheck;
+    if (typeName == "PySequence" || typeName == "PyBuffer")
+        return SequenceCheck;
+    if (hasArgumentTypeReplace())
+        return ConversionCheck;
+    if (m_argType->isContainer())
+        return SequenceCheck;
+    if (ShibokenGenerator::isNumber(m_argType) || ShibokenGenerator::isCString(m_argType)
+        || m_argType->isEnum() || m_argType->isFlags()) {
+        return TypeCheck;
+    }
+    if (ShibokenGenerator::isWrapperType(m_argType) && m_generator->implicitConversions(m_argType).isEmpty())
+        return TypeCheck;
+    return ConversionCheck;
+}
+
+int OverloadData::worstCaseCheckCount(const AbstractMetaFunction* func) const
+{
+    // Every sibling checked before the branch leading to func is paid for.
+    for (int i = 0; i < m_nextOverloadData.size(); ++i) {
+        const OverloadData* next = m_nextOverloadData.at(i);
+        if (next->overloads().contains(func))
+            return i + 1 + next->worstCaseCheckCount(func);
+    }
+    return 0;
+}
+
 /**
  * Root constructor for OverloadData
  *
@@ -820,7 +883,8 @@ QString OverloadData::dumpGraph() const
                 s << func->type()->cppSignature().replace('<', "&lt;").replace('>', "&gt;");
             else
                 s << "void";
-            s << ' ' << func->minimalSignature().replace('<', "&lt;").replace('>', "&gt;") << "\\l";
+            s << ' ' << func->minimalSignature().replace('<', "&lt;").replace('>', "&gt;");
+            s << " [worst case checks: " << worstCaseCheckCount(func) << "]\\l";
         }
         s << "\"];" << endl;
 
@@ -900,6 +964,8 @@ QString OverloadData::dumpGraph() const
             s << "<tr><td bgcolor=\"gray\" align=\"right\">orig. type</td><td bgcolor=\"gray\" align=\"left\">";
             s << argType()->cppSignature().replace("&", "&amp;") << "</td></tr>";
         }
+        s << "<tr><td bgcolor=\"gray\" align=\"right\">check cost</td><td bgcolor=\"gray\" align=\"left\">";
+        s << checkCostName(checkCost()) << "</td></tr>";
 
         // Overloads for the signature to present point
         s << "<tr><td bgcolor=\"gray\" align=\"right\">overloads</td><td bgcolor=\"gray\" align=\"left\">";
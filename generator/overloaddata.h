@@ -105,6 +105,18 @@ public:
     /// Returns true if all overloads have no more than one argument.
     static bool isSingleArgument(const AbstractMetaFunctionList& overloads);
 
+    /// Estimated runtime cost classes of the type checks done by the overload decisor, from the cheapest.
+    enum CheckCost {
+        TypeCheck,          // Type identity or number check.
+        ConversionCheck,    // Type check plus the implicit conversions of the type.
+        SequenceCheck,      // Checks every item of a sequence.
+        GenericCheck        // Accepts any object, doesn't tell overloads apart.
+    };
+    /// Returns the cost class of the type check done for the argument of the current OverloadData.
+    CheckCost checkCost() const;
+    /// Returns how many type checks, in the worst case, the decisor does before selecting \p func.
+    int worstCaseCheckCount(const AbstractMetaFunction* func) const;
+
     void dumpGraph(QString filename) const;
     QString dumpGraph() const;
 
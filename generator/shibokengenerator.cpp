@@ -23,11 +23,21 @@
 
 #include "shibokengenerator.h"
 #include "overloaddata.h"
+#include "shibokenconfig.h"
 #include <reporthandler.h>
 #include <typedatabase.h>
 
+#include <QtCore/QBuffer>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDebug>
+#include <QtCore/QTime>
+#if QT_VERSION >= 0x040700
+#include <QtCore/QElapsedTimer>
+#endif
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
 #include <limits>
 #include <memory>
 
@@ -38,6 +48,19 @@
 #define ENABLE_PYSIDE_EXTENSIONS "enable-pyside-extensions"
 #define DISABLE_VERBOSE_ERROR_MESSAGES "disable-verbose-error-messages"
 #define USE_ISNULL_AS_NB_NONZERO "use-isnull-as-nb_nonzero"
+#define LAZY_TYPE_INIT "lazy-type-init"
+#define JOBS "jobs"
+#define SHARED_CONVERTERS "shared-converters"
+#define UNITY_BUILD "unity-build"
+#define TYPE_REGISTRATION_TABLES "type-registration-tables"
+#define CODE_SIZE_REPORT "code-size-report"
+#define SKIP_UNCHANGED_CLASSES "skip-unchanged-classes"
+#define STATS "stats"
+#define ALLOW_THREAD "allow-thread"
+#define ALLOW_THREAD_CLASSES "allow-thread-classes"
+#define GIL_HOLD_DIAGNOSTICS "gil-hold-diagnostics"
+#define CALL_STATISTICS "call-statistics"
+#define STARTUP_PROFILE "startup-profile"
 
 //static void dumpFunction(AbstractMetaFunctionList lst);
 static QString baseConversionString(QString typeName);
@@ -64,6 +87,113 @@ static QString resolveScopePrefix(const AbstractMetaClass* scope, const QString&
 
     return name;
 }
+// Measures in nanoseconds the short steps, like building an overload tree, that would round down to 0 ms.
+class StepTimer
+{
+public:
+    void start() { m_timer.start(); }
+#if QT_VERSION >= 0x040700
+    qint64 nsecsElapsed() const { return m_timer.nsecsElapsed(); }
+private:
+    QElapsedTimer m_timer;
+#else
+    // Qt older than 4.7 has no clock finer than a millisecond.
+    qint64 nsecsElapsed() const { return qint64(m_timer.elapsed()) * 1000000; }
+private:
+    QTime m_timer;
+#endif
+};
+
+/// The "stats" figures of a class, or of the module code generated out of any class.
+struct GenerationStatistics
+{
+    GenerationStatistics()
+        : generateTime(0), overloadDataTime(0), overloadTrees(0), overloads(0), decisorDepth(0),
+          codeSnipTime(0), codeSnips(0), converters(0), bytes(0), lines(0) {}
+    void add(const GenerationStatistics& other)
+    {
+        generateTime += other.generateTime;
+        overloadDataTime += other.overloadDataTime;
+        overloadTrees += other.overloadTrees;
+        overloads += other.overloads;
+        decisorDepth = qMax(decisorDepth, other.decisorDepth);
+        codeSnipTime += other.codeSnipTime;
+        codeSnips += other.codeSnips;
+        converters += other.converters;
+        bytes += other.bytes;
+        lines += other.lines;
+    }
+
+    int generateTime;
+    // Nanoseconds, the time of each tree or snippet is usually far below a millisecond.
+    qint64 overloadDataTime;
+    int overloadTrees;
+    int overloads;
+    int decisorDepth;
+    // Nanoseconds.
+    qint64 codeSnipTime;
+    int codeSnips;
+    int converters;
+    qint64 bytes;
+    qint64 lines;
+};
+
+// Shared by all the generators, the report is written by the last one.
+static bool collectStatistics = false;
+static QTime statisticsTime;
+static QMutex statisticsMutex;
+static GenerationStatistics moduleStatistics;
+static QMap<QString, GenerationStatistics> classStatistics;
+// Figures of the class being generated by each thread, merged into classStatistics when it is done.
+static QThreadStorage<GenerationStatistics*> threadStatistics;
+
+static GenerationStatistics* currentStatistics()
+{
+    if (!collectStatistics)
+        return 0;
+    if (!threadStatistics.hasLocalData())
+        threadStatistics.setLocalData(new GenerationStatistics);
+    return threadStatistics.localData();
+}
+
+// Adds the time spent writing a code snippet to the current "stats" figures.
+class CodeSnipTimer
+{
+public:
+    CodeSnipTimer() : m_statistics(currentStatistics())
+    {
+        if (m_statistics)
+            m_time.start();
+    }
+    ~CodeSnipTimer()
+    {
+        if (!m_statistics)
+            return;
+        m_statistics->codeSnips++;
+        m_statistics->codeSnipTime += m_time.nsecsElapsed();
+    }
+private:
+    GenerationStatistics* m_statistics;
+    StepTimer m_time;
+};
+
+// Moves the figures collected by the current thread out of any class to the module figures.
+static void flushModuleStatistics()
+{
+    GenerationStatistics* statistics = currentStatistics();
+    QMutexLocker locker(&statisticsMutex);
+    moduleStatistics.add(*statistics);
+    *statistics = GenerationStatistics();
+}
+
+static int decisorDepth(const OverloadData* overloadData)
+{
+    int depth = 0;
+    foreach (const OverloadData* next, overloadData->nextOverloadData())
+        depth = qMax(depth, decisorDepth(next) + 1);
+    return depth;
+}
+
 ShibokenGenerator::ShibokenGenerator() : Generator()
 {
     if (m_pythonPrimitiveTypeName.isEmpty())
@@ -76,6 +206,20 @@ ShibokenGenerator::ShibokenGenerator() : Generator()
         ShibokenGenerator::initKnownPythonTypes();
 
     m_metaTypeFromStringCache = AbstractMetaTypeCache();
+    m_overloadDataCacheHits = 0;
+    m_overloadDataBuildTime = 0;
+    m_jobs = 1;
+    m_generatingInParallel = false;
+    m_generatedInParallel = false;
+    m_skipUnchangedClasses = false;
+    m_useSharedConverters = false;
+    m_unityBuildFiles = 0;
+    m_useTypeRegistrationTables = false;
+    m_allowThreadPolicy = AllowThreadAll;
+    m_useGilHoldDiagnostics = false;
+    m_useCallStatistics = false;
+    m_useStartupProfile = false;
+    m_classFingerprintsLoaded = false;
 
     m_typeSystemConvName[TypeSystemCheckFunction]         = "checkType";
     m_typeSystemConvName[TypeSystemIsConvertibleFunction] = "isConvertible";
@@ -90,6 +234,8 @@ ShibokenGenerator::ShibokenGenerator() : Generator()
 ShibokenGenerator::~ShibokenGenerator()
 {
     qDeleteAll(m_metaTypeFromStringCache.values());
+    foreach (const OverloadDataList& overloadDataList, m_overloadDataCache.values())
+        qDeleteAll(overloadDataList);
 }
 
 void ShibokenGenerator::clearTpFuncs()
@@ -315,6 +461,11 @@ QString ShibokenGenerator::protectedEnumSurrogateName(const AbstractMetaEnum* me
     return metaEnum->fullName().replace(".", "_") + "_Surrogate";
 }
 
+QString ShibokenGenerator::fileNameForClassSource(const AbstractMetaClass* metaClass)
+{
+    return metaClass->qualifiedCppName().toLower().replace("::", "_") + QLatin1String("_wrapper.cpp");
+}
+
 QString ShibokenGenerator::protectedFieldGetterName(const AbstractMetaField* field)
 {
     return QString("protected_%1_getter").arg(field->name());
@@ -415,7 +566,7 @@ QString ShibokenGenerator::guessScopeForDefaultValue(const AbstractMetaFunction*
     if (value.isEmpty())
         return QString();
 
-    static QRegExp enumValueRegEx("^([A-Za-z_]\\w*)?$");
+    QRegExp enumValueRegEx("^([A-Za-z_]\\w*)?$");
     QString prefix;
     QString suffix;
 
@@ -424,7 +575,7 @@ QString ShibokenGenerator::guessScopeForDefaultValue(const AbstractMetaFunction*
         if (metaEnum)
             prefix = resolveScopePrefix(metaEnum->enclosingClass(), value);
     } else if (arg->type()->isFlags()) {
-        static QRegExp numberRegEx("^\\d+$"); // Numbers to flags
+        QRegExp numberRegEx("^\\d+$"); // Numbers to flags
         if (numberRegEx.exactMatch(value)) {
             QString typeName = translateTypeForWrapperMethod(arg->type(), func->implementingClass());
             if (arg->type()->isConstant())
@@ -435,7 +586,7 @@ QString ShibokenGenerator::guessScopeForDefaultValue(const AbstractMetaFunction*
             suffix = ')';
         }
 
-        static QRegExp enumCombinationRegEx("^([A-Za-z_][\\w:]*)\\(([^,\\(\\)]*)\\)$"); // FlagName(EnumItem|EnumItem|...)
+        QRegExp enumCombinationRegEx("^([A-Za-z_][\\w:]*)\\(([^,\\(\\)]*)\\)$"); // FlagName(EnumItem|EnumItem|...)
         if (prefix.isEmpty() && enumCombinationRegEx.indexIn(value) != -1) {
             QString flagName = enumCombinationRegEx.cap(1);
             QStringList enumItems = enumCombinationRegEx.cap(2).split("|");
@@ -461,7 +612,7 @@ QString ShibokenGenerator::guessScopeForDefaultValue(const AbstractMetaFunction*
         if (enumValueRegEx.exactMatch(value) && func->implementingClass())
             prefix = resolveScopePrefix(func->implementingClass(), value);
     } else if(arg->type()->isPrimitive()) {
-        static QRegExp unknowArgumentRegEx("^(?:[A-Za-z_][\\w:]*\\()?([A-Za-z_]\\w*)(?:\\))?$"); // [PrimitiveType(] DESIREDNAME [)]
+        QRegExp unknowArgumentRegEx("^(?:[A-Za-z_][\\w:]*\\()?([A-Za-z_]\\w*)(?:\\))?$"); // [PrimitiveType(] DESIREDNAME [)]
         if (unknowArgumentRegEx.indexIn(value) != -1 && func->implementingClass()) {
             foreach (const AbstractMetaField* field, func->implementingClass()->fields()) {
                 if (unknowArgumentRegEx.cap(1).trimmed() == field->name()) {
@@ -540,6 +691,8 @@ static QString baseConversionString(QString typeName)
 
 void ShibokenGenerator::writeBaseConversion(QTextStream& s, const TypeEntry* type)
 {
+    if (GenerationStatistics* statistics = currentStatistics())
+        statistics->converters++;
     QString typeName;
 
     if (avoidProtectedHack() && type->isEnum()) {
@@ -557,6 +710,8 @@ void ShibokenGenerator::writeBaseConversion(QTextStream& s, const TypeEntry* typ
 void ShibokenGenerator::writeBaseConversion(QTextStream& s, const AbstractMetaType* type,
                                             const AbstractMetaClass* context, Options options)
 {
+    if (GenerationStatistics* statistics = currentStatistics())
+        statistics->converters++;
     QString typeName;
     if (type->isPrimitive()) {
         const PrimitiveTypeEntry* ptype = (const PrimitiveTypeEntry*) type->typeEntry();
@@ -588,6 +743,163 @@ void ShibokenGenerator::writeToPythonConversion(QTextStream& s, const AbstractMe
     s << cpythonToPythonConversionFunction(type, context) << '(' << argumentName << ')';
 }
 
+void ShibokenGenerator::writeTypeConverterImpl(QTextStream& s, const TypeEntry* type, bool inlineImpl)
+{
+    if (type->hasNativeConversionRule())
+        return;
+
+    QString pyTypeName = cpythonTypeName(type);
+
+    AbstractMetaFunctionList implicitConvs;
+    foreach (AbstractMetaFunction* func, implicitConversions(type)) {
+        if (!func->isUserAdded())
+            implicitConvs << func;
+    }
+
+    bool hasImplicitConversions = !implicitConvs.isEmpty();
+
+    // A specialized Converter<T>::toCpp method is only need for
+    // classes with implicit conversions.
+    if (!hasImplicitConversions)
+        return;
+
+    const QString typeName = "::" + type->qualifiedCppName();
+
+    // Write Converter<T>::isConvertible
+    s << (inlineImpl ? "inline " : "") << "bool Shiboken::Converter< " << typeName << " >::isConvertible(PyObject* pyobj)" << endl;
+    s << '{' << endl;
+
+    if (type->isValue()) {
+        s << INDENT << "if (ValueTypeConverter< " << typeName << " >::isConvertible(pyobj))" << endl;
+        Indentation indent(INDENT);
+        s << INDENT << "return true;" << endl;
+    }
+
+
+    s << INDENT << "SbkObjectType* shiboType = reinterpret_cast<SbkObjectType*>(SbkType< ";
+    s << typeName << " >());" << endl;
+    s << INDENT << "return ";
+    bool isFirst = true;
+    foreach (const AbstractMetaFunction* ctor, implicitConvs) {
+        Indentation indent(INDENT);
+        if (isFirst)
+            isFirst = false;
+        else
+            s << endl << INDENT << " || ";
+        if (ctor->isConversionOperator())
+            s << cpythonCheckFunction(ctor->ownerClass()->typeEntry());
+        else
+            s << cpythonCheckFunction(ctor->arguments().first()->type());
+        s << "(pyobj)";
+    }
+    s << endl;
+    {
+        Indentation indent(INDENT);
+        s << INDENT << " || (ObjectType::isExternalConvertible(shiboType, pyobj));" << endl;
+    }
+    s << '}' << endl << endl;
+
+    // Write Converter<T>::toCpp function
+    s << (inlineImpl ? "inline " : "") << typeName << " Shiboken::Converter< " << typeName << " >::toCpp(PyObject* pyobj)" << endl;
+    s << '{' << endl;
+
+    s << INDENT << "if (PyObject_TypeCheck(pyobj, SbkType< " << typeName << " >()))" << endl;
+    {
+        Indentation indent(INDENT);
+        s << INDENT << "return *" << cpythonWrapperCPtr(type, "pyobj") << ';' << endl;
+    }
+
+    foreach (const AbstractMetaFunction* ctor, implicitConvs) {
+        if (ctor->isModifiedRemoved())
+            continue;
+
+        s << INDENT << "else ";
+
+        QString typeCheck;
+        QString toCppConv;
+        QTextStream tcc(&toCppConv);
+        if (ctor->isConversionOperator()) {
+            const AbstractMetaClass* metaClass = ctor->ownerClass();
+            typeCheck = cpythonCheckFunction(metaClass->typeEntry());
+            writeToCppConversion(tcc, metaClass, "pyobj");
+        } else {
+            const AbstractMetaType* argType = ctor->arguments().first()->type();
+            typeCheck = cpythonCheckFunction(argType);
+            writeToCppConversion(tcc, argType, 0, "pyobj");
+        }
+
+        s << "if (" << typeCheck << "(pyobj))" << endl;
+        {
+            Indentation indent(INDENT);
+            s << INDENT << "return " << type->name() << '(' << toCppConv << ");" << endl;
+        }
+    }
+
+    {
+        s << INDENT << "else" << endl;
+        {
+            Indentation indent(INDENT);
+            s << INDENT << "return Shiboken::ValueTypeConverter< " << typeName << " >::toCpp(pyobj);" << endl;
+        }
+    }
+    s << '}' << endl << endl;
+}
+
+bool ShibokenGenerator::hasSharedConverter(const TypeEntry* type) const
+{
+    return useSharedConverters() && (type->isValue() || type->isObject()) && !type->hasNativeConversionRule();
+}
+
+void ShibokenGenerator::writeSharedConverterImpl(QTextStream& s, const TypeEntry* type)
+{
+    if (!hasSharedConverter(type))
+        return;
+
+    const AbstractMetaClass* metaClass = classes().findClass(type->name());
+    bool isAbstractOrObjectType = (metaClass &&  metaClass->isAbstract()) || type->isObject();
+    const QString typeName = "::" + type->qualifiedCppName();
+
+    if (isAbstractOrObjectType) {
+        QString converter = "Shiboken::Converter< " + typeName + "* >";
+        s << "PyObject* " << converter << "::toPython(const " << typeName << "* cppobj)" << endl;
+        s << '{' << endl;
+        s << INDENT << "return ObjectTypeConverter< " << typeName << " >::toPython(cppobj);" << endl;
+        s << '}' << endl << endl;
+        s << typeName << "* " << converter << "::toCpp(PyObject* pyobj)" << endl;
+        s << '{' << endl;
+        s << INDENT << "return ObjectTypeConverter< " << typeName << " >::toCpp(pyobj);" << endl;
+        s << '}' << endl << endl;
+        return;
+    }
+
+    QString converter = "Shiboken::Converter< " + typeName + " >";
+    s << "PyObject* " << converter << "::toPython(const " << typeName << "& cppobj)" << endl;
+    s << '{' << endl;
+    s << INDENT << "return ValueTypeConverter< " << typeName << " >::toPython(cppobj);" << endl;
+    s << '}' << endl << endl;
+    s << "#ifdef SBK_HAS_RVALUE_REFERENCES" << endl;
+    s << "PyObject* " << converter << "::toPython(" << typeName << "&& cppobj)" << endl;
+    s << '{' << endl;
+    s << INDENT << "return ValueTypeConverter< " << typeName << " >::toPython(std::move(cppobj));" << endl;
+    s << '}' << endl;
+    s << "#endif" << endl << endl;
+    // Classes with implicit conversions already have an specialized toCpp.
+    bool hasImplicitConversions = false;
+    foreach (AbstractMetaFunction* func, implicitConversions(type))
+        hasImplicitConversions |= !func->isUserAdded();
+    if (!hasImplicitConversions) {
+        s << typeName << ' ' << converter << "::toCpp(PyObject* pyobj)" << endl;
+        s << '{' << endl;
+        s << INDENT << "return ValueTypeConverter< " << typeName << " >::toCpp(pyobj);" << endl;
+        s << '}' << endl << endl;
+    }
+}
+
+QString ShibokenGenerator::sharedConvertersMacro() const
+{
+    return "SBK_" + moduleName().toUpper() + "_SHARED_CONVERTERS";
+}
+
 void ShibokenGenerator::writeToCppConversion(QTextStream& s, const AbstractMetaClass* metaClass,
                                              const QString& argumentName)
 {
@@ -655,7 +967,7 @@ QString ShibokenGenerator::getFormatUnitString(const AbstractMetaFunction* func,
                                  << "::" << func->signature() << " => Arg:"
                                  << arg->name() << "index: " << arg->argumentIndex()
                                  << " - cannot be handled properly. Use an inject-code to fix it!";
-            ReportHandler::warning(report);
+            ShibokenGenerator::warning(report);
             result += '?';
         }
     }
@@ -736,14 +1048,23 @@ QString ShibokenGenerator::cpythonTypeName(const TypeEntry* type)
 
 QString ShibokenGenerator::cpythonTypeNameExt(const TypeEntry* type)
 {
-    return cppApiVariableName(type->targetLangPackage()) + '[' + getTypeIndexVariableName(type) + ']';
+    if (useLazyTypeInit())
+        return "Shiboken::Module::loadType(" + cppApiVariableName(type->targetLangPackage()) + ", " + getTypeIndexVariableName(type) + ')';
+    return cpythonTypeSlot(type);
 }
 
 QString ShibokenGenerator::cpythonTypeNameExt(const AbstractMetaType* type)
 {
+    if (useLazyTypeInit())
+        return "Shiboken::Module::loadType(" + cppApiVariableName(type->typeEntry()->targetLangPackage()) + ", " + getTypeIndexVariableName(type) + ')';
     return cppApiVariableName(type->typeEntry()->targetLangPackage()) + '[' + getTypeIndexVariableName(type) + ']';
 }
 
+QString ShibokenGenerator::cpythonTypeSlot(const TypeEntry* type)
+{
+    return cppApiVariableName(type->targetLangPackage()) + '[' + getTypeIndexVariableName(type) + ']';
+}
+
 QString ShibokenGenerator::cpythonOperatorFunctionName(const AbstractMetaFunction* func)
 {
     if (!func->isOperatorOverload())
@@ -768,7 +1089,7 @@ QString ShibokenGenerator::pythonOperatorFunctionName(QString cppOpFuncName)
 {
     QString value = m_pythonOperators.value(cppOpFuncName);
     if (value.isEmpty()) {
-        ReportHandler::warning("Unknown operator: "+cppOpFuncName);
+        ShibokenGenerator::warning("Unknown operator: "+cppOpFuncName);
         value = "UNKNOWN_OPERATOR";
     }
     value.prepend("__").append("__");
@@ -1268,27 +1589,128 @@ QString ShibokenGenerator::getCodeSnippets(const CodeSnipList& codeSnips,
     }
     return code;
 }
+static inline bool isVariableNameChar(QChar c)
+{
+    return (c >= 'A' && c <= 'Z') || c.isDigit() || c == '_';
+}
+
+/// Splits \p code in literal text and type system variables, i.e. %NAME, %NAME. and %NUMBER.
+static CodeSnipTemplate parseCodeSnip(const QString& code)
+{
+    CodeSnipTemplate tokens;
+    CodeSnipToken literal = { false, QString() };
+    const int size = code.size();
+    int pos = 0;
+    while (pos < size) {
+        int begin = code.indexOf('%', pos);
+        int end = begin + 1;
+        if (begin != -1 && end < size) {
+            if (code.at(end).isDigit()) {
+                while (end < size && code.at(end).isDigit())
+                    ++end;
+            } else if (code.at(end) >= 'A' && code.at(end) <= 'Z') {
+                while (end < size && isVariableNameChar(code.at(end)))
+                    ++end;
+            }
+        }
+        if (begin == -1 || end == begin + 1) {
+            // No variable here, the '%' (if any) is literal.
+            int literalEnd = begin == -1 ? size : begin + 1;
+            literal.text.append(code.midRef(pos, literalEnd - pos));
+            pos = literalEnd;
+            continue;
+        }
+        literal.text.append(code.midRef(pos, begin - pos));
+        if (!literal.text.isEmpty()) {
+            tokens << literal;
+            literal.text.clear();
+        }
+        if (end < size && code.at(end) == '.')
+            ++end;
+        CodeSnipToken variable = { true, code.mid(begin + 1, end - begin - 1) };
+        tokens << variable;
+        pos = end;
+    }
+    if (!literal.text.isEmpty())
+        tokens << literal;
+    return tokens;
+}
+
+/**
+ *  Writes the value of the variable \p name to \p s, with the same result of replacing,
+ *  one after the other, all the variables in \p variables in the original code.
+ *  A variable "NAME." not in \p variables is expanded as "NAME" followed by '.', and a variable
+ *  not found is expanded as the longest variable it starts with followed by the rest of the name.
+ *  \returns false if no variable matches \p name.
+ */
+static bool expandCodeSnipVariable(QString& s, const QString& name, const QHash<QString, QString>& variables)
+{
+    QHash<QString, QString>::const_iterator it = variables.constFind(name);
+    if (it != variables.constEnd()) {
+        s += it.value();
+        return true;
+    }
+    for (int length = name.size() - 1; length > 0; --length) {
+        it = variables.constFind(name.left(length));
+        if (it != variables.constEnd()) {
+            s += it.value();
+            s.append(name.midRef(length));
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Expands \p snip replacing the type system variables by their values in \p variables.
+static QString expandCodeSnip(const CodeSnipTemplate& snip, const QHash<QString, QString>& variables)
+{
+    QString code;
+    for (int i = 0; i < snip.size(); ++i) {
+        const CodeSnipToken& token = snip.at(i);
+        if (!token.isVariable) {
+            code += token.text;
+            continue;
+        }
+        // "%TYPE::%FUNCTION_NAME" may have its own replacement.
+        if (token.text == "TYPE" && i + 2 < snip.size() && variables.contains("TYPE::%FUNCTION_NAME")
+            && !snip.at(i + 1).isVariable && snip.at(i + 1).text == "::"
+            && snip.at(i + 2).isVariable
+            && (snip.at(i + 2).text == "FUNCTION_NAME" || snip.at(i + 2).text == "FUNCTION_NAME.")) {
+            code += variables["TYPE::%FUNCTION_NAME"];
+            if (snip.at(i + 2).text.endsWith('.'))
+                code += '.';
+            i += 2;
+            continue;
+        }
+        if (!expandCodeSnipVariable(code, token.text, variables))
+            code += '%' + token.text;
+    }
+    return code;
+}
+
+CodeSnipTemplate ShibokenGenerator::codeSnipTemplate(const QString& code)
+{
+    QMutexLocker locker(&m_codeSnipTemplatesMutex);
+    QHash<QString, CodeSnipTemplate>::const_iterator it = m_codeSnipTemplates.constFind(code);
+    if (it != m_codeSnipTemplates.constEnd())
+        return it.value();
+    return m_codeSnipTemplates[code] = parseCodeSnip(code);
+}
+
 void ShibokenGenerator::processCodeSnip(QString& code, const AbstractMetaClass* context)
 {
     if (context) {
         // Replace template variable by the Python Type object
         // for the class context in which the variable is used.
-        code.replace("%PYTHONTYPEOBJECT", cpythonTypeName(context) + ".super.ht_type");
-        code.replace("%TYPE", wrapperName(context));
-        code.replace("%CPPTYPE", context->name());
+        QHash<QString, QString> variables;
+        variables["PYTHONTYPEOBJECT"] = cpythonTypeName(context) + ".super.ht_type";
+        variables["TYPE"] = wrapperName(context);
+        variables["CPPTYPE"] = context->name();
+        code = expandCodeSnip(parseCodeSnip(code), variables);
     }
 
-    // replace "toPython" converters
-    replaceConvertToPythonTypeSystemVariable(code);
-
-    // replace "toCpp" converters
-    replaceConvertToCppTypeSystemVariable(code);
-
-    // replace "isConvertible" check
-    replaceIsConvertibleToCppTypeSystemVariable(code);
-
-    // replace "checkType" check
-    replaceTypeCheckTypeSystemVariable(code);
+    // replace "toPython", "toCpp", "isConvertible" and "checkType" converters
+    replaceConverterTypeSystemVariables(code);
 }
 
 ShibokenGenerator::ArgumentVarReplacementList ShibokenGenerator::getArgumentReplacement(const AbstractMetaFunction* func,
@@ -1339,6 +1761,7 @@ void ShibokenGenerator::writeCodeSnips(QTextStream& s,
     QString code = getCodeSnippets(codeSnips, position, language);
     if (code.isEmpty())
         return;
+    CodeSnipTimer timer;
     processCodeSnip(code, context);
     s << INDENT << "// Begin code injection" << endl;
     s << code;
@@ -1355,68 +1778,108 @@ void ShibokenGenerator::writeCodeSnips(QTextStream& s,
     QString code = getCodeSnippets(codeSnips, position, language);
     if (code.isEmpty())
         return;
+    CodeSnipTimer timer;
+
+    bool usePyArgs = pythonFunctionWrapperUsesListOfArguments(getOverloadData(func));
+
+    // Replaces the simplest case of attribution to a
+    // Python argument on the binding virtual method.
+    if (language == TypeSystem::NativeCode && code.contains("%PYARG_")) {
+        code.replace("%PYARG_0", PYTHON_RETURN_VAR);
+        QRegExp pyArgsAttributionRegex("%PYARG_(\\d+)\\s*=[^=]\\s*([^;]+)");
+        code.replace(pyArgsAttributionRegex, "PyTuple_SET_ITEM(" PYTHON_ARGS ", \\1-1, \\2)");
+    }
+
+    QString pySelf = (language == TypeSystem::NativeCode) ? "pySelf" : PYTHON_SELF_VAR;
 
-    // Calculate the real number of arguments.
-    int argsRemoved = 0;
-    for (int i = 0; i < func->arguments().size(); i++) {
-        if (func->argumentRemoved(i+1))
-            argsRemoved++;
+    // Rewrites calls to the C++ method from the Python override, so that they don't recurse.
+    if (func->implementingClass() && func->isVirtual() && !func->isAbstract()
+        && (!avoidProtectedHack() || !func->isProtected())) {
+        QString methodCallArgs = getArgumentsFromMethodCall(code);
+        if (!methodCallArgs.isNull()) {
+            if (func->name() == "metaObject") {
+                QString wrapperClassName = wrapperName(func->ownerClass());
+                QString cppSelfVar = avoidProtectedHack() ? QString("%CPPSELF") : QString("reinterpret_cast<%1*>(%CPPSELF)").arg(wrapperClassName);
+                code.replace(QString("%CPPSELF.%FUNCTION_NAME(%1)").arg(methodCallArgs),
+                             QString("(Shiboken::Object::hasCppWrapper(reinterpret_cast<SbkObject*>(%1))"
+                                     " ? %2->::%3::%FUNCTION_NAME(%4)"
+                                     " : %CPPSELF.%FUNCTION_NAME(%4))").arg(pySelf).arg(cppSelfVar).arg(wrapperClassName).arg(methodCallArgs));
+            } else {
+                code.replace(QString("%CPPSELF.%FUNCTION_NAME(%1)").arg(methodCallArgs),
+                             QString("(Shiboken::Object::hasCppWrapper(reinterpret_cast<SbkObject*>(%1))"
+                                     " ? %CPPSELF->::%TYPE::%FUNCTION_NAME(%2)"
+                                     " : %CPPSELF.%FUNCTION_NAME(%2))").arg(pySelf).arg(methodCallArgs));
+            }
+        }
     }
 
-    OverloadData od(getFunctionGroups(func->implementingClass())[func->name()], this);
-    bool usePyArgs = pythonFunctionWrapperUsesListOfArguments(od);
+    // The snippet is parsed once, and all its variables are expanded in a single pass.
+    CodeSnipTemplate snip = codeSnipTemplate(code);
+    QHash<QString, QString> variables;
 
     // Replace %PYARG_# variables.
-    code.replace("%PYARG_0", PYTHON_RETURN_VAR);
-
-    static QRegExp pyArgsRegex("%PYARG_(\\d+)");
-    if (language == TypeSystem::TargetLangCode) {
-        if (usePyArgs) {
-            code.replace(pyArgsRegex, PYTHON_ARGS"[\\1-1]");
-        } else {
-            static QRegExp pyArgsRegexCheck("%PYARG_([2-9]+)");
-            if (pyArgsRegexCheck.indexIn(code) != -1) {
-                ReportHandler::warning("Wrong index for %PYARG variable ("+pyArgsRegexCheck.cap(1)+") on "+func->signature());
-                return;
+    variables["PYARG_0"] = PYTHON_RETURN_VAR;
+    int beginAllowThreads = 0;
+    int endAllowThreads = 0;
+    foreach (const CodeSnipToken& token, snip) {
+        if (!token.isVariable)
+            continue;
+        QString name = token.text;
+        if (name.endsWith('.'))
+            name.chop(1);
+        if (name == "BEGIN_ALLOW_THREADS") {
+            ++beginAllowThreads;
+        } else if (name == "END_ALLOW_THREADS") {
+            ++endAllowThreads;
+        } else if (name.startsWith("PYARG_") && name.size() > 6 && name.at(6).isDigit()) {
+            QString index = name.mid(6);
+            int indexLength = 0;
+            while (indexLength < index.size() && index.at(indexLength).isDigit())
+                ++indexLength;
+            index.truncate(indexLength);
+            if (index == "0")
+                continue;
+            if (language == TypeSystem::TargetLangCode && !usePyArgs) {
+                int wrongIndexLength = 0;
+                while (wrongIndexLength < index.size() && index.at(wrongIndexLength) >= '2' && index.at(wrongIndexLength) <= '9')
+                    ++wrongIndexLength;
+                if (wrongIndexLength) {
+                    ShibokenGenerator::warning("Wrong index for %PYARG variable ("+index.left(wrongIndexLength)+") on "+func->signature());
+                    return;
+                }
+            } else if (language == TypeSystem::TargetLangCode) {
+                variables["PYARG_" + index] = QString(PYTHON_ARGS"[%1-1]").arg(index);
+            } else {
+                variables["PYARG_" + index] = QString("PyTuple_GET_ITEM(" PYTHON_ARGS ", %1-1)").arg(index);
             }
-            code.replace("%PYARG_1", PYTHON_ARG);
         }
-    } else {
-        // Replaces the simplest case of attribution to a
-        // Python argument on the binding virtual method.
-        static QRegExp pyArgsAttributionRegex("%PYARG_(\\d+)\\s*=[^=]\\s*([^;]+)");
-        code.replace(pyArgsAttributionRegex, "PyTuple_SET_ITEM(" PYTHON_ARGS ", \\1-1, \\2)");
-        code.replace(pyArgsRegex, "PyTuple_GET_ITEM(" PYTHON_ARGS ", \\1-1)");
     }
+    if (language == TypeSystem::TargetLangCode && !usePyArgs)
+        variables["PYARG_1"] = PYTHON_ARG;
 
     // Replace %ARG#_TYPE variables.
-    foreach (const AbstractMetaArgument* arg, func->arguments()) {
-        QString argTypeVar = QString("%ARG%1_TYPE").arg(arg->argumentIndex() + 1);
-        QString argTypeVal = arg->type()->cppSignature();
-        code.replace(argTypeVar, argTypeVal);
-    }
+    foreach (const AbstractMetaArgument* arg, func->arguments())
+        variables[QString("ARG%1_TYPE").arg(arg->argumentIndex() + 1)] = arg->type()->cppSignature();
 
-    int pos = 0;
-    static QRegExp cppArgTypeRegexCheck("%ARG(\\d+)_TYPE");
-    while ((pos = cppArgTypeRegexCheck.indexIn(code, pos)) != -1) {
-        ReportHandler::warning("Wrong index for %ARG#_TYPE variable ("+cppArgTypeRegexCheck.cap(1)+") on "+func->signature());
-        pos += cppArgTypeRegexCheck.matchedLength();
+    QRegExp cppArgTypeRegexCheck("^ARG(\\d+)_TYPE");
+    foreach (const CodeSnipToken& token, snip) {
+        if (token.isVariable && cppArgTypeRegexCheck.indexIn(token.text) != -1 && !variables.contains(cppArgTypeRegexCheck.cap(0)))
+            ShibokenGenerator::warning("Wrong index for %ARG#_TYPE variable ("+cppArgTypeRegexCheck.cap(1)+") on "+func->signature());
     }
 
     // Replace template variable for return variable name.
     if (func->isConstructor()) {
-        code.replace("%0.", QString("%1->").arg("cptr"));
-        code.replace("%0", "cptr");
+        variables["0."] = "cptr->";
+        variables["0"] = "cptr";
     } else if (func->type()) {
         QString returnValueOp = isPointerToWrapperType(func->type()) ? "%1->" : "%1.";
         if (ShibokenGenerator::isWrapperType(func->type()))
-            code.replace("%0.", returnValueOp.arg(CPP_RETURN_VAR));
-        code.replace("%0", CPP_RETURN_VAR);
+            variables["0."] = returnValueOp.arg(CPP_RETURN_VAR);
+        variables["0"] = CPP_RETURN_VAR;
     }
 
     // Replace template variable for self Python object.
-    QString pySelf = (language == TypeSystem::NativeCode) ? "pySelf" : PYTHON_SELF_VAR;
-    code.replace("%PYSELF", pySelf);
+    variables["PYSELF"] = pySelf;
 
     // Replace template variable for a pointer to C++ of this object.
     if (func->implementingClass()) {
@@ -1433,44 +1896,25 @@ void ShibokenGenerator::writeCodeSnips(QTextStream& s,
         if (func->isComparisonOperator())
             replacement = "%1.";
 
-        if (func->isVirtual() && !func->isAbstract() && (!avoidProtectedHack() || !func->isProtected())) {
-            QString methodCallArgs = getArgumentsFromMethodCall(code);
-            if (!methodCallArgs.isNull()) {
-                if (func->name() == "metaObject") {
-                    QString wrapperClassName = wrapperName(func->ownerClass());
-                    QString cppSelfVar = avoidProtectedHack() ? QString("%CPPSELF") : QString("reinterpret_cast<%1*>(%CPPSELF)").arg(wrapperClassName);
-                    code.replace(QString("%CPPSELF.%FUNCTION_NAME(%1)").arg(methodCallArgs),
-                                 QString("(Shiboken::Object::hasCppWrapper(reinterpret_cast<SbkObject*>(%1))"
-                                         " ? %2->::%3::%FUNCTION_NAME(%4)"
-                                         " : %CPPSELF.%FUNCTION_NAME(%4))").arg(pySelf).arg(cppSelfVar).arg(wrapperClassName).arg(methodCallArgs));
-                } else {
-                    code.replace(QString("%CPPSELF.%FUNCTION_NAME(%1)").arg(methodCallArgs),
-                                 QString("(Shiboken::Object::hasCppWrapper(reinterpret_cast<SbkObject*>(%1))"
-                                         " ? %CPPSELF->::%TYPE::%FUNCTION_NAME(%2)"
-                                         " : %CPPSELF.%FUNCTION_NAME(%2))").arg(pySelf).arg(methodCallArgs));
-                }
-            }
-        }
-
-        code.replace("%CPPSELF.", replacement.arg(cppSelf));
-        code.replace("%CPPSELF", cppSelf);
+        variables["CPPSELF."] = replacement.arg(cppSelf);
+        variables["CPPSELF"] = cppSelf;
 
-        if (code.indexOf("%BEGIN_ALLOW_THREADS") > -1) {
-            if (code.count("%BEGIN_ALLOW_THREADS") == code.count("%END_ALLOW_THREADS")) {
-                code.replace("%BEGIN_ALLOW_THREADS", BEGIN_ALLOW_THREADS);
-                code.replace("%END_ALLOW_THREADS", END_ALLOW_THREADS);
+        if (beginAllowThreads) {
+            if (beginAllowThreads == endAllowThreads) {
+                variables["BEGIN_ALLOW_THREADS"] = BEGIN_ALLOW_THREADS;
+                variables["END_ALLOW_THREADS"] = END_ALLOW_THREADS;
             } else {
-                ReportHandler::warning("%BEGIN_ALLOW_THREADS and %END_ALLOW_THREADS mismatch");
+                ShibokenGenerator::warning("%BEGIN_ALLOW_THREADS and %END_ALLOW_THREADS mismatch");
             }
         }
 
         // replace template variable for the Python Type object for the
         // class implementing the method in which the code snip is written
         if (func->isStatic()) {
-            code.replace("%PYTHONTYPEOBJECT", cpythonTypeName(func->implementingClass()) + ".super.ht_type");
+            variables["PYTHONTYPEOBJECT"] = cpythonTypeName(func->implementingClass()) + ".super.ht_type";
         } else {
-            code.replace("%PYTHONTYPEOBJECT.", QString("%1->ob_type->").arg(pySelf));
-            code.replace("%PYTHONTYPEOBJECT", QString("%1->ob_type").arg(pySelf));
+            variables["PYTHONTYPEOBJECT."] = QString("%1->ob_type->").arg(pySelf);
+            variables["PYTHONTYPEOBJECT"] = QString("%1->ob_type").arg(pySelf);
         }
     }
 
@@ -1484,26 +1928,26 @@ void ShibokenGenerator::writeCodeSnips(QTextStream& s,
             continue;
         args << pair.second;
     }
-    code.replace("%ARGUMENT_NAMES", args.join(", "));
+    variables["ARGUMENT_NAMES"] = args.join(", ");
 
     foreach (ArgumentVarReplacementPair pair, argReplacements) {
         const AbstractMetaArgument* arg = pair.first;
         int idx = arg->argumentIndex() + 1;
         QString replacement = pair.second;
         if (isWrapperType(arg->type()) && isPointer(arg->type()))
-            code.replace(QString("%%1.").arg(idx), QString("%1->").arg(replacement));
-        code.replace(QString("%%1").arg(idx), replacement);
+            variables[QString("%1.").arg(idx)] = QString("%1->").arg(replacement);
+        variables[QString::number(idx)] = replacement;
     }
 
     if (language == TypeSystem::NativeCode) {
         // Replaces template %PYTHON_ARGUMENTS variable with a pointer to the Python tuple
         // containing the converted virtual method arguments received from C++ to be passed
         // to the Python override.
-        code.replace("%PYTHON_ARGUMENTS", PYTHON_ARGS);
+        variables["PYTHON_ARGUMENTS"] = PYTHON_ARGS;
 
         // replace variable %PYTHON_METHOD_OVERRIDE for a pointer to the Python method
         // override for the C++ virtual method in which this piece of code was inserted
-        code.replace("%PYTHON_METHOD_OVERRIDE", PYTHON_OVERRIDE_VAR);
+        variables["PYTHON_METHOD_OVERRIDE"] = PYTHON_OVERRIDE_VAR;
     }
 
     if (avoidProtectedHack()) {
@@ -1519,19 +1963,20 @@ void ShibokenGenerator::writeCodeSnips(QTextStream& s,
         }
 
         if (func->isProtected() || hasProtectedOverload) {
-            code.replace("%TYPE::%FUNCTION_NAME",
-                         QString("%1::%2_protected")
-                         .arg(wrapperName(func->ownerClass()))
-                         .arg(func->originalName()));
-            code.replace("%FUNCTION_NAME", QString("%1_protected").arg(func->originalName()));
+            variables["TYPE::%FUNCTION_NAME"] = QString("%1::%2_protected")
+                                                .arg(wrapperName(func->ownerClass()))
+                                                .arg(func->originalName());
+            variables["FUNCTION_NAME"] = QString("%1_protected").arg(func->originalName());
         }
     }
 
     if (func->isConstructor() && shouldGenerateCppWrapper(func->ownerClass()))
-        code.replace("%TYPE", wrapperName(func->ownerClass()));
+        variables["TYPE"] = wrapperName(func->ownerClass());
 
     if (func->ownerClass())
-        code.replace("%CPPTYPE", func->ownerClass()->name());
+        variables["CPPTYPE"] = func->ownerClass()->name();
+
+    code = expandCodeSnip(snip, variables);
 
     replaceTemplateVariables(code, func);
 
@@ -1544,43 +1989,75 @@ void ShibokenGenerator::writeCodeSnips(QTextStream& s,
 typedef QPair<QString, QString> StringPair;
 void ShibokenGenerator::replaceConverterTypeSystemVariable(TypeSystemConverterVariable converterVariable, QString& code)
 {
-    QRegExp& regex = m_typeSystemConvRegEx[converterVariable];
-    const QString& conversionName = m_typeSystemConvName[converterVariable];
+    QRegExp regex = m_typeSystemConvRegEx[converterVariable];
     int pos = 0;
     QList<StringPair> replacements;
     while ((pos = regex.indexIn(code, pos)) != -1) {
         pos += regex.matchedLength();
         QStringList list = regex.capturedTexts();
-        QString conversionVar = list.first();
-        QString conversionTypeName = list.last();
-        const AbstractMetaType* conversionType = buildAbstractMetaTypeFromString(conversionTypeName);
-        QString conversion;
-        if (conversionType) {
-            switch (converterVariable) {
-                case TypeSystemCheckFunction:
-                    conversion = cpythonCheckFunction(conversionType);
-                    break;
-                case TypeSystemIsConvertibleFunction:
-                    conversion = cpythonIsConvertibleFunction(conversionType);
-                    break;
-                case TypeSystemToCppFunction:
-                    conversion = cpythonToCppConversionFunction(conversionType);
-                    break;
-                case TypeSystemToPythonFunction:
-                    conversion = cpythonToPythonConversionFunction(conversionType);
-                    break;
-                default:
-                    Q_ASSERT(false);
-            }
-        } else {
-            conversion = QString("Shiboken::Converter< %1 >::%2").arg(conversionTypeName).arg(conversionName);
-        }
-        replacements.append(qMakePair(conversionVar, conversion));
+        replacements.append(qMakePair(list.first(), converterTypeSystemVariable(converterVariable, list.last())));
     }
     foreach (StringPair rep, replacements)
         code.replace(rep.first, rep.second);
 }
 
+QString ShibokenGenerator::converterTypeSystemVariable(TypeSystemConverterVariable converterVariable, const QString& typeName)
+{
+    const AbstractMetaType* conversionType = buildAbstractMetaTypeFromString(typeName);
+    if (!conversionType)
+        return QString("Shiboken::Converter< %1 >::%2").arg(typeName).arg(m_typeSystemConvName[converterVariable]);
+    switch (converterVariable) {
+        case TypeSystemCheckFunction:
+            return cpythonCheckFunction(conversionType);
+        case TypeSystemIsConvertibleFunction:
+            return cpythonIsConvertibleFunction(conversionType);
+        case TypeSystemToCppFunction:
+            return cpythonToCppConversionFunction(conversionType);
+        case TypeSystemToPythonFunction:
+            return cpythonToPythonConversionFunction(conversionType);
+        default:
+            Q_ASSERT(false);
+    }
+    return QString();
+}
+
+// Same order of the TypeSystemConverterVariable enum.
+static const char* converterVariableNames[] = {
+    "%CHECKTYPE[", "%ISCONVERTIBLE[", "%CONVERTTOCPP[", "%CONVERTTOPYTHON["
+};
+
+void ShibokenGenerator::replaceConverterTypeSystemVariables(QString& code)
+{
+    int pos = code.indexOf('%');
+    if (pos == -1)
+        return;
+    QString result;
+    int copied = 0;
+    for (; pos != -1; pos = code.indexOf('%', pos + 1)) {
+        for (int i = 0; i < TypeSystemConverterVariables; ++i) {
+            QLatin1String name(converterVariableNames[i]);
+            int nameSize = qstrlen(converterVariableNames[i]);
+            if (code.midRef(pos, nameSize) != name)
+                continue;
+            // The type name goes up to the last ']' before the next '['.
+            int typeBegin = pos + nameSize;
+            int nextBracket = code.indexOf('[', typeBegin);
+            int typeEnd = code.lastIndexOf(']', nextBracket == -1 ? -1 : nextBracket - 1);
+            if (typeEnd < typeBegin)
+                break;
+            result += code.midRef(copied, pos - copied);
+            result += converterTypeSystemVariable(TypeSystemConverterVariable(i), code.mid(typeBegin, typeEnd - typeBegin));
+            copied = typeEnd + 1;
+            pos = typeEnd;
+            break;
+        }
+    }
+    if (!copied)
+        return;
+    result += code.midRef(copied);
+    code = result;
+}
+
 bool ShibokenGenerator::injectedCodeUsesCppSelf(const AbstractMetaFunction* func)
 {
     CodeSnipList snips = func->injectedCodeSnips(CodeSnip::Any, TypeSystem::TargetLangCode);
@@ -1623,7 +2100,7 @@ bool ShibokenGenerator::injectedCodeCallsCppFunction(const AbstractMetaFunction*
 
 bool ShibokenGenerator::injectedCodeCallsPythonOverride(const AbstractMetaFunction* func)
 {
-    static QRegExp overrideCallRegexCheck("PyObject_Call\\s*\\(\\s*%PYTHON_METHOD_OVERRIDE\\s*,");
+    QRegExp overrideCallRegexCheck("PyObject_Call\\s*\\(\\s*%PYTHON_METHOD_OVERRIDE\\s*,");
     CodeSnipList snips = func->injectedCodeSnips(CodeSnip::Any, TypeSystem::NativeCode);
     foreach (CodeSnip snip, snips) {
         if (overrideCallRegexCheck.indexIn(snip.code()) != -1)
@@ -1634,8 +2111,8 @@ bool ShibokenGenerator::injectedCodeCallsPythonOverride(const AbstractMetaFuncti
 
 bool ShibokenGenerator::injectedCodeHasReturnValueAttribution(const AbstractMetaFunction* func, TypeSystem::Language language)
 {
-    static QRegExp retValAttributionRegexCheck_native("%0\\s*=[^=]\\s*.+");
-    static QRegExp retValAttributionRegexCheck_target("%PYARG_0\\s*=[^=]\\s*.+");
+    QRegExp retValAttributionRegexCheck_native("%0\\s*=[^=]\\s*.+");
+    QRegExp retValAttributionRegexCheck_target("%PYARG_0\\s*=[^=]\\s*.+");
     CodeSnipList snips = func->injectedCodeSnips(CodeSnip::Any, language);
     foreach (CodeSnip snip, snips) {
         if (language == TypeSystem::TargetLangCode) {
@@ -1783,6 +2260,8 @@ AbstractMetaType* ShibokenGenerator::buildAbstractMetaTypeFromString(QString typ
 {
     typeSignature = typeSignature.trimmed();
 
+    QMutexLocker locker(&m_metaTypeFromStringCacheMutex);
+
     if (m_metaTypeFromStringCache.contains(typeSignature))
         return m_metaTypeFromStringCache.value(typeSignature);
 
@@ -1871,6 +2350,97 @@ AbstractMetaFunctionList ShibokenGenerator::getFunctionOverloads(const AbstractM
 
 }
 
+static bool isSameOverloadList(const OverloadData* overloadData, const AbstractMetaFunctionList& overloads)
+{
+    const QList<const AbstractMetaFunction*>& cached = overloadData->overloads();
+    if (cached.size() != overloads.size())
+        return false;
+    for (int i = 0; i < overloads.size(); ++i) {
+        if (cached[i] != overloads[i])
+            return false;
+    }
+    return true;
+}
+
+static OverloadData* findOverloadData(const OverloadDataList& cachedList, const AbstractMetaFunctionList& overloads)
+{
+    foreach (OverloadData* overloadData, cachedList) {
+        if (isSameOverloadList(overloadData, overloads))
+            return overloadData;
+    }
+    return 0;
+}
+
+OverloadData& ShibokenGenerator::getOverloadData(const AbstractMetaFunctionList& overloads)
+{
+    return overloadDataFromCache(overloads);
+}
+
+OverloadData& ShibokenGenerator::overloadDataFromCache(const AbstractMetaFunctionList& overloads)
+{
+    FunctionGroupKey key;
+    if (!overloads.isEmpty())
+        key = FunctionGroupKey(overloads.first()->implementingClass(), overloads.first()->name());
+
+    // The same group may be asked with and without some of its functions, e.g. the removed ones.
+    {
+        QMutexLocker locker(&m_overloadDataCacheMutex);
+        if (OverloadData* cached = findOverloadData(m_overloadDataCache.value(key), overloads)) {
+            m_overloadDataCacheHits++;
+            return *cached;
+        }
+    }
+
+    // Built without the lock, so the other threads are not kept waiting on it.
+    StepTimer time;
+    time.start();
+    OverloadData* overloadData = new OverloadData(overloads, this);
+    qint64 elapsed = time.nsecsElapsed();
+
+    QMutexLocker locker(&m_overloadDataCacheMutex);
+    OverloadDataList& cachedList = m_overloadDataCache[key];
+    // Another thread may have built the same tree meanwhile.
+    if (OverloadData* cached = findOverloadData(cachedList, overloads)) {
+        delete overloadData;
+        m_overloadDataCacheHits++;
+        return *cached;
+    }
+    m_overloadDataBuildTime += elapsed;
+    if (GenerationStatistics* statistics = currentStatistics()) {
+        statistics->overloadDataTime += elapsed;
+        statistics->overloadTrees++;
+        statistics->overloads += overloads.size();
+        statistics->decisorDepth = qMax(statistics->decisorDepth, decisorDepth(overloadData));
+    }
+    cachedList.append(overloadData);
+    return *overloadData;
+}
+
+OverloadData& ShibokenGenerator::getOverloadData(const AbstractMetaFunction* func)
+{
+    FunctionGroupKey key(func->implementingClass(), func->name());
+    {
+        QMutexLocker locker(&m_overloadDataCacheMutex);
+        if (OverloadData* overloadData = m_functionGroupOverloadData.value(key)) {
+            m_overloadDataCacheHits++;
+            return *overloadData;
+        }
+    }
+    OverloadData* overloadData = &overloadDataFromCache(getFunctionOverloads(func->implementingClass(), func->name()));
+    QMutexLocker locker(&m_overloadDataCacheMutex);
+    m_functionGroupOverloadData.insert(key, overloadData);
+    return *overloadData;
+}
+
+void ShibokenGenerator::reportOverloadDataStatistics() const
+{
+    int built = 0;
+    foreach (const OverloadDataList& overloadDataList, m_overloadDataCache.values())
+        built += overloadDataList.size();
+    ShibokenGenerator::debugSparse(QString("Overload data: %1 trees built in %2 ms, %3 requests served from the cache")
+                               .arg(built).arg(m_overloadDataBuildTime / 1e6, 0, 'f', 3).arg(m_overloadDataCacheHits));
+}
+
 QPair< int, int > ShibokenGenerator::getMinMaxArguments(const AbstractMetaFunction* metaFunction)
 {
     AbstractMetaFunctionList overloads = getFunctionOverloads(metaFunction->ownerClass(), metaFunction->name());
@@ -1898,6 +2468,19 @@ QMap<QString, QString> ShibokenGenerator::options() const
     opts.insert(ENABLE_PYSIDE_EXTENSIONS, "Enable PySide extensions, such as support for signal/slots, use this if you are creating a binding for a Qt-based library.");
     opts.insert(DISABLE_VERBOSE_ERROR_MESSAGES, "Disable verbose error messages. Turn the python code hard to debug but safe few kB on the generated bindings.");
     opts.insert(USE_ISNULL_AS_NB_NONZERO, "If a class have an isNull()const method, it will be used to compute the value of boolean casts");
+    opts.insert(LAZY_TYPE_INIT, "Initialize the Python types of the module on their first use instead of on module import.");
+    opts.insert(JOBS, "Number of threads used to generate the classes code, the output is the same of the serial generation.");
+    opts.insert(SHARED_CONVERTERS, "Define the converters of the module types once, in the module source file, instead of inline in every source file using them.");
+    opts.insert(UNITY_BUILD, "Write the given number of unity build source files, each one including a share of the class wrappers.");
+    opts.insert(TYPE_REGISTRATION_TABLES, "Register the module types from constant tables processed by libshiboken instead of per-class initialization code.");
+    opts.insert(CODE_SIZE_REPORT, "Write to the given file the size of the code generated for each type.");
+    opts.insert(STATS, "Write to the given file a JSON report of the generation time and output size of each class.");
+    opts.insert(SKIP_UNCHANGED_CLASSES, "Do not generate again the code of classes whose description did not change since the last run.");
+    opts.insert(ALLOW_THREAD, "Calls to C++ that release the GIL: \"all\" (default), \"heuristic\" to keep it on trivial calls, or \"marked\" for functions with allow-thread only.");
+    opts.insert(ALLOW_THREAD_CLASSES, "Comma separated list of classes whose methods always release the GIL, whatever the allow-thread policy.");
+    opts.insert(CALL_STATISTICS, "Count the calls to each bound function and virtual method override, their overloads and time spent, readable with Shiboken::CallStatistics::dump().");
+    opts.insert(GIL_HOLD_DIAGNOSTICS, "Time the C++ calls made without releasing the GIL when SHIBOKEN_GIL_HOLD_REPORT is set on the environment.");
+    opts.insert(STARTUP_PROFILE, "Time the steps of the module initialization, reported when SHIBOKEN_STARTUP_PROFILE is set on the environment.");
     return opts;
 }
 
@@ -1909,6 +2492,37 @@ bool ShibokenGenerator::doSetup(const QMap<QString, QString>& args)
     m_verboseErrorMessagesDisabled = args.contains(DISABLE_VERBOSE_ERROR_MESSAGES);
     m_useIsNullAsNbNonZero = args.contains(USE_ISNULL_AS_NB_NONZERO);
     m_avoidProtectedHack = args.contains(AVOID_PROTECTED_HACK);
+    m_useLazyTypeInit = args.contains(LAZY_TYPE_INIT);
+    m_jobs = qMax(args.value(JOBS, "1").toInt(), 1);
+    m_skipUnchangedClasses = args.contains(SKIP_UNCHANGED_CLASSES);
+    m_useSharedConverters = args.contains(SHARED_CONVERTERS);
+    m_codeSizeReportFileName = args.value(CODE_SIZE_REPORT);
+    m_statisticsFileName = args.value(STATS);
+    if (!m_statisticsFileName.isEmpty() && !collectStatistics) {
+        collectStatistics = true;
+        statisticsTime.start();
+    }
+    m_unityBuildFiles = qMax(args.value(UNITY_BUILD, "0").toInt(), 0);
+    // Lazily initialized types are registered one by one, on their first use.
+    m_useTypeRegistrationTables = args.contains(TYPE_REGISTRATION_TABLES) && !m_useLazyTypeInit;
+    QString allowThread = args.value(ALLOW_THREAD, "all");
+    if (allowThread == "heuristic") {
+        m_allowThreadPolicy = AllowThreadHeuristic;
+    } else if (allowThread == "marked") {
+        m_allowThreadPolicy = AllowThreadMarked;
+    } else {
+        if (allowThread != "all")
+            ReportHandler::warning(QString("Unknown allow-thread policy '%1', using 'all'.").arg(allowThread));
+        m_allowThreadPolicy = AllowThreadAll;
+    }
+    m_allowThreadClasses = args.value(ALLOW_THREAD_CLASSES).split(',', QString::SkipEmptyParts);
+    m_useGilHoldDiagnostics = args.contains(GIL_HOLD_DIAGNOSTICS);
+    m_useCallStatistics = args.contains(CALL_STATISTICS);
+    m_useStartupProfile = args.contains(STARTUP_PROFILE);
+    m_generatorArguments.clear();
+    QMap<QString, QString>::const_iterator it = args.constBegin();
+    for (; it != args.constEnd(); ++it)
+        m_generatorArguments += it.key() + '=' + it.value() + '\n';
     return true;
 }
 
@@ -1937,6 +2551,441 @@ bool ShibokenGenerator::avoidProtectedHack() const
     return m_avoidProtectedHack;
 }
 
+bool ShibokenGenerator::useLazyTypeInit() const
+{
+    return m_useLazyTypeInit;
+}
+
+bool ShibokenGenerator::useSharedConverters() const
+{
+    return m_useSharedConverters;
+}
+
+bool ShibokenGenerator::useTypeRegistrationTables() const
+{
+    return m_useTypeRegistrationTables;
+}
+
+int ShibokenGenerator::unityBuildFiles() const
+{
+    return m_unityBuildFiles;
+}
+
+QString ShibokenGenerator::codeSizeReportFileName() const
+{
+    return m_codeSizeReportFileName;
+}
+
+QString ShibokenGenerator::statisticsFileName() const
+{
+    return m_statisticsFileName;
+}
+
+int ShibokenGenerator::jobs() const
+{
+    return m_jobs;
+}
+
+bool ShibokenGenerator::useGilHoldDiagnostics() const
+{
+    return m_useGilHoldDiagnostics;
+}
+
+bool ShibokenGenerator::useCallStatistics() const
+{
+    return m_useCallStatistics;
+}
+
+bool ShibokenGenerator::useStartupProfile() const
+{
+    return m_useStartupProfile;
+}
+
+// Functions expected to return before releasing and taking back the GIL costs more than the call.
+static bool isTrivialCall(const AbstractMetaFunction* func)
+{
+    if (func->isOperatorOverload())
+        return !func->isCallOperator();
+    int numArgs = func->arguments().count();
+    if (func->isConstant() && numArgs == 0)
+        return true;
+    return !func->type() && numArgs == 1 && func->name().startsWith("set");
+}
+
+bool ShibokenGenerator::shouldReleaseGil(const AbstractMetaFunction* func) const
+{
+    if (func->allowThread())
+        return true;
+    const AbstractMetaClass* ownerClass = func->ownerClass();
+    if (ownerClass && m_allowThreadClasses.contains(ownerClass->qualifiedCppName()))
+        return true;
+    if (m_allowThreadPolicy == AllowThreadAll)
+        return true;
+    if (m_allowThreadPolicy == AllowThreadMarked || isTrivialCall(func))
+        return false;
+    // Functions handling Python objects are better off with the GIL.
+    if (func->type() && m_knownPythonTypes.contains(func->type()->typeEntry()->name()))
+        return false;
+    foreach (const AbstractMetaArgument* arg, func->arguments()) {
+        if (m_knownPythonTypes.contains(arg->type()->typeEntry()->name()))
+            return false;
+    }
+    return true;
+}
+
+ThreadIndentor::operator Indentor&() const
+{
+    if (!m_indentors.hasLocalData())
+        m_indentors.setLocalData(new Indentor);
+    return *m_indentors.localData();
+}
+
+static QMutex reportMutex;
+
+void ShibokenGenerator::warning(const QString& message)
+{
+    QMutexLocker locker(&reportMutex);
+    ReportHandler::warning(message);
+}
+
+void ShibokenGenerator::debugSparse(const QString& message)
+{
+    QMutexLocker locker(&reportMutex);
+    ReportHandler::debugSparse(message);
+}
+
+/// Generates the code of a class in one of the threads of the pool.
+class ClassGenerationJob : public QRunnable
+{
+public:
+    ClassGenerationJob(ShibokenGenerator* generator, const AbstractMetaClass* metaClass, QString* code)
+        : m_generator(generator), m_metaClass(metaClass), m_code(code) {}
+
+    void run()
+    {
+        QTextStream s(m_code);
+        m_generator->generateClass(s, m_metaClass);
+    }
+
+private:
+    ShibokenGenerator* m_generator;
+    const AbstractMetaClass* m_metaClass;
+    QString* m_code;
+};
+
+QString ShibokenGenerator::classFingerprintFileName() const
+{
+    return outputDirectory() + '/' + subDirectoryForPackage(packageName()) + "/.shiboken_fingerprints";
+}
+
+QString ShibokenGenerator::classOutputFileName(const AbstractMetaClass* metaClass) const
+{
+    return subDirectoryForClass(metaClass) + '/' + fileNameForClass(metaClass);
+}
+
+static void describeFunction(QTextStream& s, const AbstractMetaFunction* func)
+{
+    s << func->minimalSignature() << ' ' << func->modifiedName() << ' ' << func->isVirtual()
+      << func->isAbstract() << func->isStatic() << func->isProtected() << func->isPrivate();
+    if (func->type())
+        s << ' ' << func->type()->cppSignature();
+    for (int i = 0; i <= func->arguments().size(); ++i)
+        s << ' ' << func->argumentRemoved(i) << func->typeReplaced(i);
+    s << endl;
+    foreach (const AbstractMetaArgument* arg, func->arguments()) {
+        s << "param " << arg->name() << ' ' << arg->defaultValueExpression()
+          << ' ' << arg->originalDefaultValueExpression() << endl;
+    }
+    for (int i = 0; i <= func->arguments().size(); ++i) {
+        s << "rule " << i << endl << func->conversionRule(TypeSystem::NativeCode, i) << endl
+          << func->conversionRule(TypeSystem::TargetLangCode, i) << endl;
+    }
+    foreach (const FunctionModification& mod, func->modifications()) {
+        s << "mod " << mod.modifiers << endl;
+        foreach (const ArgumentModification& argMod, mod.argument_mods) {
+            s << "arg " << argMod.index << ' ' << argMod.noNullPointers << ' ' << argMod.removedDefaultExpression
+              << ' ' << argMod.replacedDefaultExpression << ' ' << int(argMod.owner.action) << ':' << argMod.owner.index;
+            foreach (TypeSystem::Language lang, argMod.ownerships.keys())
+                s << ' ' << int(lang) << ':' << int(argMod.ownerships[lang]);
+            foreach (const ReferenceCount& refCount, argMod.referenceCounts)
+                s << " ref " << int(refCount.action) << ':' << refCount.varName;
+            s << endl;
+        }
+    }
+    foreach (const CodeSnip& snip, func->injectedCodeSnips())
+        s << "snip " << snip.position << ' ' << snip.language << endl << snip.code() << endl;
+}
+
+QString ShibokenGenerator::classFingerprint(const AbstractMetaClass* metaClass)
+{
+    // Anything that changes the code of every class, the same for the whole module.
+    if (m_moduleFingerprint.isEmpty()) {
+        QString moduleDescription;
+        QTextStream m(&moduleDescription);
+        m << SHIBOKEN_VERSION << endl << m_generatorArguments << moduleName() << endl << licenseComment() << endl;
+        foreach (const AbstractMetaClass* cls, classes())
+            m << cls->qualifiedCppName() << ' ';
+        m.flush();
+        m_moduleFingerprint = QCryptographicHash::hash(moduleDescription.toUtf8(), QCryptographicHash::Md5).toHex();
+    }
+
+    QString description;
+    QTextStream s(&description);
+    s << m_moduleFingerprint << endl;
+    s << metaClass->qualifiedCppName() << ' ' << metaClass->isPolymorphic() << ' '
+      << metaClass->isAbstract() << ' ' << metaClass->hasPrivateDestructor() << endl;
+    s << metaClass->baseClassNames().join(" ") << endl;
+    s << metaClass->typeEntry()->include().toString() << endl;
+    foreach (const Include& include, metaClass->typeEntry()->extraIncludes())
+        s << include.toString() << endl;
+    s << "rule " << metaClass->typeEntry()->conversionRule() << endl;
+    foreach (const CodeSnip& snip, metaClass->typeEntry()->codeSnips())
+        s << "snip " << snip.position << ' ' << snip.language << endl << snip.code() << endl;
+
+    QSet<const AbstractMetaClass*> usedClasses;
+    foreach (const AbstractMetaFunction* func, metaClass->functions()) {
+        describeFunction(s, func);
+        QList<const AbstractMetaType*> types;
+        if (func->type())
+            types << func->type();
+        foreach (const AbstractMetaArgument* arg, func->arguments())
+            types << arg->type();
+        foreach (const AbstractMetaType* type, types) {
+            if (const AbstractMetaClass* cls = classes().findClass(type->typeEntry()->name()))
+                usedClasses << cls;
+        }
+    }
+    foreach (const AbstractMetaField* field, metaClass->fields())
+        s << "field " << field->name() << ' ' << field->type()->cppSignature() << endl;
+    foreach (const AbstractMetaEnum* cppEnum, metaClass->enums()) {
+        s << "enum " << cppEnum->name();
+        foreach (const AbstractMetaEnumValue* enumValue, cppEnum->values())
+            s << ' ' << enumValue->name() << '=' << enumValue->value();
+        s << endl;
+    }
+    foreach (const AbstractMetaClass* innerClass, metaClass->innerClasses())
+        s << "inner " << innerClass->qualifiedCppName() << endl;
+
+    // The conversions of argument and return types depend on their classes' constructors.
+    QStringList usedClassesDescription;
+    foreach (const AbstractMetaClass* cls, usedClasses) {
+        QString usedClass = cls->qualifiedCppName() + ' ' + QString::number(cls->isPolymorphic())
+                            + QString::number(cls->typeEntry()->isValue());
+        foreach (const AbstractMetaFunction* ctor, cls->queryFunctions(AbstractMetaClass::Constructors))
+            usedClass += ' ' + ctor->minimalSignature();
+        usedClassesDescription << usedClass;
+    }
+    usedClassesDescription.sort();
+    s << usedClassesDescription.join("\n") << endl;
+
+    s.flush();
+    return QCryptographicHash::hash(description.toUtf8(), QCryptographicHash::Md5).toHex();
+}
+
+bool ShibokenGenerator::classIsUnchanged(const AbstractMetaClass* metaClass)
+{
+    if (!m_skipUnchangedClasses)
+        return false;
+    QHash<const AbstractMetaClass*, bool>::const_iterator cached = m_unchangedClasses.constFind(metaClass);
+    if (cached != m_unchangedClasses.constEnd())
+        return cached.value();
+
+    // Generators run one after the other, each one keeping the fingerprints written by the previous.
+    if (!m_classFingerprintsLoaded) {
+        m_classFingerprintsLoaded = true;
+        QFile file(classFingerprintFileName());
+        if (file.open(QFile::ReadOnly)) {
+            QTextStream s(&file);
+            while (!s.atEnd()) {
+                QStringList entry = s.readLine().split(' ');
+                if (entry.size() == 2)
+                    m_classFingerprints[entry.first()] = entry.last();
+            }
+        }
+    }
+
+    QString fileName = classOutputFileName(metaClass);
+    QString fingerprint = classFingerprint(metaClass);
+    bool unchanged = m_classFingerprints.value(fileName) == fingerprint
+                     && QFile::exists(outputDirectory() + '/' + fileName);
+    m_classFingerprints[fileName] = fingerprint;
+    m_unchangedClasses[metaClass] = unchanged;
+    return unchanged;
+}
+
+bool ShibokenGenerator::writeUnchangedClassCode(QTextStream& s, const AbstractMetaClass* metaClass)
+{
+    if (m_generatingInParallel || !classIsUnchanged(metaClass))
+        return false;
+    QFile file(outputDirectory() + '/' + classOutputFileName(metaClass));
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    // Writes the same contents again, so that the file isn't touched.
+    s << QString::fromUtf8(file.readAll());
+    debugSparse("Skipping unchanged " + metaClass->fullName());
+    return true;
+}
+
+void ShibokenGenerator::writeClassFingerprints()
+{
+    if (!m_skipUnchangedClasses)
+        return;
+    QFile file(classFingerprintFileName());
+    verifyDirectoryFor(file);
+    if (!file.open(QFile::WriteOnly)) {
+        warning("Error writing file: " + file.fileName());
+        return;
+    }
+    QTextStream s(&file);
+    QStringList fileNames = m_classFingerprints.keys();
+    fileNames.sort();
+    foreach (const QString& fileName, fileNames)
+        s << fileName << ' ' << m_classFingerprints[fileName] << endl;
+    m_classFingerprintsLoaded = false;
+    m_classFingerprints.clear();
+}
+
+ShibokenGenerator::StatisticsCollector::StatisticsCollector(QTextStream& s, const AbstractMetaClass* metaClass)
+    : m_stream(s), m_metaClass(metaClass)
+{
+    if (!collectStatistics)
+        return;
+    flushModuleStatistics();
+    m_time.start();
+}
+
+ShibokenGenerator::StatisticsCollector::~StatisticsCollector()
+{
+    GenerationStatistics* statistics = currentStatistics();
+    if (!statistics)
+        return;
+    statistics->generateTime += m_time.elapsed();
+    m_stream.flush();
+    if (m_stream.string()) {
+        statistics->bytes += m_stream.string()->toUtf8().size();
+        statistics->lines += m_stream.string()->count('\n');
+    } else if (QBuffer* buffer = qobject_cast<QBuffer*>(m_stream.device())) {
+        statistics->bytes += buffer->data().size();
+        statistics->lines += buffer->data().count('\n');
+    }
+
+    QMutexLocker locker(&statisticsMutex);
+    classStatistics[m_metaClass->qualifiedCppName()].add(*statistics);
+    *statistics = GenerationStatistics();
+}
+
+static void writeStatisticsObject(QTextStream& s, const GenerationStatistics& statistics)
+{
+    s << "{ \"generate_ms\": " << statistics.generateTime;
+    s << ", \"overload_data_ms\": " << QString::number(statistics.overloadDataTime / 1e6, 'f', 3);
+    s << ", \"overload_trees\": " << statistics.overloadTrees;
+    s << ", \"overloads\": " << statistics.overloads;
+    s << ", \"max_decisor_depth\": " << statistics.decisorDepth;
+    s << ", \"code_snip_ms\": " << QString::number(statistics.codeSnipTime / 1e6, 'f', 3);
+    s << ", \"code_snips\": " << statistics.codeSnips;
+    s << ", \"converters\": " << statistics.converters;
+    s << ", \"bytes\": " << statistics.bytes;
+    s << ", \"lines\": " << statistics.lines << " }";
+}
+
+void ShibokenGenerator::writeStatistics()
+{
+    if (m_statisticsFileName.isEmpty())
+        return;
+    flushModuleStatistics();
+
+    QFile file(m_statisticsFileName);
+    if (!file.open(QFile::WriteOnly)) {
+        warning("Error writing file: " + file.fileName());
+        return;
+    }
+
+    QMutexLocker locker(&statisticsMutex);
+    GenerationStatistics total = moduleStatistics;
+    foreach (const GenerationStatistics& statistics, classStatistics)
+        total.add(statistics);
+    // The generation time of the classes doesn't account for the module code and the parsing.
+    total.generateTime = statisticsTime.elapsed();
+
+    QTextStream s(&file);
+    s << "{" << endl;
+    s << "  \"module\": \"" << moduleName() << "\"," << endl;
+    s << "  \"total\": ";
+    writeStatisticsObject(s, total);
+    s << ',' << endl << "  \"module_code\": ";
+    writeStatisticsObject(s, moduleStatistics);
+    s << ',' << endl << "  \"classes\": {";
+    QMap<QString, GenerationStatistics>::const_iterator it = classStatistics.constBegin();
+    for (; it != classStatistics.constEnd(); ++it) {
+        s << (it == classStatistics.constBegin() ? "" : ",") << endl;
+        s << "    \"" << it.key() << "\": ";
+        writeStatisticsObject(s, it.value());
+    }
+    s << endl << "  }" << endl << "}" << endl;
+}
+
+bool ShibokenGenerator::writeCodeGeneratedInParallel(QTextStream& s, const AbstractMetaClass* metaClass)
+{
+    // The worker threads generate the code themselves.
+    if (m_jobs < 2 || m_generatingInParallel)
+        return false;
+
+    if (!m_generatedInParallel) {
+        m_generatedInParallel = true;
+        generateClassesInParallel();
+    }
+
+    QHash<const AbstractMetaClass*, QString>::iterator it = m_codeGeneratedInParallel.find(metaClass);
+    if (it == m_codeGeneratedInParallel.end())
+        return false;
+    s << it.value();
+    m_codeGeneratedInParallel.erase(it);
+    return true;
+}
+
+void ShibokenGenerator::generateClassesInParallel()
+{
+    // Same classes for which Generator::generate() calls generateClass().
+    AbstractMetaClassList classList;
+    foreach (AbstractMetaClass* metaClass, classes()) {
+        if (shouldGenerate(metaClass) && !fileNameForClass(metaClass).isNull() && !classIsUnchanged(metaClass))
+            classList << metaClass;
+    }
+
+    // Some ApiExtractor objects cache values computed on their first use,
+    // this must happen before the threads start to share them.
+    foreach (AbstractMetaClass* metaClass, classes()) {
+        foreach (const AbstractMetaFunction* func, metaClass->functions()) {
+            func->minimalSignature();
+            func->signature();
+            func->modifiedName();
+            if (func->type())
+                func->type()->cppSignature();
+            foreach (const AbstractMetaArgument* arg, func->arguments())
+                arg->type()->cppSignature();
+        }
+        foreach (const AbstractMetaField* field, metaClass->fields())
+            field->type()->cppSignature();
+    }
+
+    // The code buffers are created before the jobs start, and no job changes the hash.
+    foreach (const AbstractMetaClass* metaClass, classList)
+        m_codeGeneratedInParallel.insert(metaClass, QString());
+
+    QTime time;
+    time.start();
+    m_generatingInParallel = true;
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_jobs);
+    foreach (const AbstractMetaClass* metaClass, classList)
+        pool.start(new ClassGenerationJob(this, metaClass, &m_codeGeneratedInParallel[metaClass]));
+    pool.waitForDone();
+    m_generatingInParallel = false;
+
+    debugSparse(QString("Generated %1 classes in %2 ms using %3 threads")
+                .arg(classList.size()).arg(time.elapsed()).arg(m_jobs));
+}
+
 QString ShibokenGenerator::cppApiVariableName(const QString& moduleName) const
 {
     QString result = moduleName.isEmpty() ? ShibokenGenerator::packageName() : moduleName;
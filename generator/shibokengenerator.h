@@ -36,18 +36,45 @@
 #define PYTHON_RETURN_VAR         "pyResult"
 #define PYTHON_SELF_VAR           "self"
 #define THREAD_STATE_SAVER_VAR    "threadStateSaver"
-#define BEGIN_ALLOW_THREADS       "PyThreadState* _save = PyEval_SaveThread(); // Py_BEGIN_ALLOW_THREADS"
-#define END_ALLOW_THREADS         "PyEval_RestoreThread(_save); // Py_END_ALLOW_THREADS"
+#define BEGIN_ALLOW_THREADS       "Shiboken::Trace::event(Shiboken::Trace::GilReleased); "\
+                                  "PyThreadState* _save = PyEval_SaveThread(); // Py_BEGIN_ALLOW_THREADS"
+#define END_ALLOW_THREADS         "PyEval_RestoreThread(_save); "\
+                                  "Shiboken::Trace::event(Shiboken::Trace::GilAcquired); // Py_END_ALLOW_THREADS"
 #define MIN_CTOR_ERROR_MSG        "Could not find a minimal constructor for type '%1'. "\
                                   "This will result in a compilation error."
 
 #include <generator.h>
 #include <QtCore/QTextStream>
+#include <QtCore/QMutex>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QTime>
 
 #include "overloaddata.h"
 
 class DocParser;
 
+/**
+ * Indentation level of the code being written. Each thread generating code gets
+ * its own Indentor, so that classes can be generated in parallel.
+ */
+class ThreadIndentor
+{
+public:
+    operator Indentor&() const;
+private:
+    mutable QThreadStorage<Indentor*> m_indentors;
+};
+
+/// A piece of the user's custom code: literal text, or a type system variable.
+struct CodeSnipToken
+{
+    bool isVariable;
+    /// The literal text, or the variable name without the '%', ending with '.' if followed by one.
+    QString text;
+};
+/// User's custom code parsed once, and expanded for every function using it.
+typedef QList<CodeSnipToken> CodeSnipTemplate;
+
 /**
  * Abstract generator that contains common methods used in CppGenerator and HeaderGenerator.
  */
@@ -73,6 +100,22 @@ public:
     */
     AbstractMetaFunctionList getFunctionOverloads(const AbstractMetaClass* scope, const QString& functionName);
     /**
+    *   Returns the OverloadData tree for the list of \p overloads. Each tree is built and sorted only
+    *   once per generator run, later requests for the same overloads get the cached tree.
+    */
+    OverloadData& getOverloadData(const AbstractMetaFunctionList& overloads);
+    /**
+    *   Returns the OverloadData tree for all the overloads of \p func in its implementing class.
+    */
+    OverloadData& getOverloadData(const AbstractMetaFunction* func);
+    /// Reports how many OverloadData trees were built, the time it took and the cache hits.
+    void reportOverloadDataStatistics() const;
+
+    /// Same as ReportHandler::warning, but safe to call while classes are generated in parallel.
+    static void warning(const QString& message);
+    /// Same as ReportHandler::debugSparse, but safe to call while classes are generated in parallel.
+    static void debugSparse(const QString& message);
+    /**
     *   Returns the minimun and maximun number of arguments which this function and all overloads
     *   can accept. Arguments removed by typesystem are considered as well.
     */
@@ -250,6 +293,15 @@ public:
     void writeToCppConversion(QTextStream& s, const AbstractMetaType* type, const AbstractMetaClass* context, const QString& argumentName);
     void writeToCppConversion(QTextStream& s, const AbstractMetaClass* metaClass, const QString& argumentName);
 
+    /// Writes the Converter<T>::toCpp and isConvertible functions of types with implicit conversions.
+    void writeTypeConverterImpl(QTextStream& s, const TypeEntry* type, bool inlineImpl = true);
+    /// Returns true if the toPython and toCpp functions of the \p type converter are defined in the module source file.
+    bool hasSharedConverter(const TypeEntry* type) const;
+    /// Writes the out of line toPython and toCpp functions of the \p type converter.
+    void writeSharedConverterImpl(QTextStream& s, const TypeEntry* type);
+    /// Name of the macro defined by the module source files when the converters are shared.
+    QString sharedConvertersMacro() const;
+
     /// Returns true if the argument is a pointer that rejects NULL values.
     static bool shouldRejectNullPointerArgument(const AbstractMetaFunction* func, int argIndex);
 
@@ -262,6 +314,8 @@ public:
     const AbstractMetaClass* getProperEnclosingClassForEnum(const AbstractMetaEnum* metaEnum);
 
     QString wrapperName(const AbstractMetaClass* metaClass) const;
+    /// Returns the name of the wrapper source file written by the CppGenerator for \p metaClass.
+    static QString fileNameForClassSource(const AbstractMetaClass* metaClass);
 
     static QString fullPythonFunctionName(const AbstractMetaFunction* func);
     static QString protectedEnumSurrogateName(const AbstractMetaEnum* metaEnum);
@@ -314,6 +368,8 @@ public:
     QString cpythonTypeName(const TypeEntry* type);
     QString cpythonTypeNameExt(const TypeEntry* type);
     QString cpythonTypeNameExt(const AbstractMetaType* type);
+    /// Returns the entry of the module types array for \p type, to be used where the type is being created.
+    QString cpythonTypeSlot(const TypeEntry* type);
     QString cpythonCheckFunction(const TypeEntry* type, bool genericNumberType = false);
     QString cpythonCheckFunction(const AbstractMetaType* metaType, bool genericNumberType = false);
     /**
@@ -393,6 +449,26 @@ public:
     bool useIsNullAsNbNonZero() const;
     /// Returns true if the generated code should use the "#define protected public" hack.
     bool avoidProtectedHack() const;
+    /// Returns true if the Python types should be initialized on their first use.
+    bool useLazyTypeInit() const;
+    /// Returns true if the converters should be defined once, in the module source file.
+    bool useSharedConverters() const;
+    /// Returns true if the module types should be registered from constant tables.
+    bool useTypeRegistrationTables() const;
+    /// Returns the number of unity build source files to write, or 0 if they weren't requested.
+    int unityBuildFiles() const;
+    /// Returns the name of the file receiving the code size report, or an empty string if it wasn't requested.
+    QString codeSizeReportFileName() const;
+    /// Returns the name of the file receiving the JSON statistics report, or an empty string if it wasn't requested.
+    QString statisticsFileName() const;
+    /// Returns true if the generated code must release the GIL while calling the C++ function \p func.
+    bool shouldReleaseGil(const AbstractMetaFunction* func) const;
+    /// Returns true if the C++ calls made holding the GIL should be timed by the generated code.
+    bool useGilHoldDiagnostics() const;
+    /// Returns true if the generated wrappers should count their calls and the time spent on them.
+    bool useCallStatistics() const;
+    /// Returns true if the module initialization code should time its steps.
+    bool useStartupProfile() const;
     QString cppApiVariableName(const QString& moduleName = QString()) const;
     /**
      *  Returns the type index variable name for a given class. If \p alternativeTemplateName is true
@@ -468,7 +544,42 @@ protected:
     /// Returns true if the Python wrapper for the received OverloadData must accept a list of arguments.
     static bool pythonFunctionWrapperUsesListOfArguments(const OverloadData& overloadData);
 
-    Indentor INDENT;
+    ThreadIndentor INDENT;
+
+    /**
+     *  Returns the number of threads used to generate the classes, as set by the "jobs" option.
+     */
+    int jobs() const;
+    /**
+     *  When more than one job is used, the first call generates the code of all classes in
+     *  parallel, and each call writes the code generated for \p metaClass to \p s.
+     *  Generators must call this at the beginning of generateClass().
+     *  \returns false if the caller must generate the code of \p metaClass itself.
+     */
+    bool writeCodeGeneratedInParallel(QTextStream& s, const AbstractMetaClass* metaClass);
+
+    /**
+     *  With the "skip-unchanged-classes" option, writes to \p s the current contents of the file
+     *  generated for \p metaClass if the class description didn't change since the last run.
+     *  Generators must call this at the beginning of generateClass().
+     *  \returns false if the caller must generate the code of \p metaClass.
+     */
+    bool writeUnchangedClassCode(QTextStream& s, const AbstractMetaClass* metaClass);
+    /// Saves the fingerprints of the generated classes for the next run, must be called by finishGeneration().
+    void writeClassFingerprints();
+
+    /// Helper class collecting the "stats" figures of a class while its code is generated to \p s.
+    class StatisticsCollector {
+    public:
+        StatisticsCollector(QTextStream& s, const AbstractMetaClass* metaClass);
+        ~StatisticsCollector();
+    private:
+        QTextStream& m_stream;
+        const AbstractMetaClass* m_metaClass;
+        QTime m_time;
+    };
+    /// Writes the "stats" JSON report, must be called by the finishGeneration() of the last generator.
+    void writeStatistics();
 
     enum TypeSystemConverterVariable {
         TypeSystemCheckFunction = 0,
@@ -478,6 +589,10 @@ protected:
         TypeSystemConverterVariables
     };
     void replaceConverterTypeSystemVariable(TypeSystemConverterVariable converterVariable, QString& code);
+    /// Returns the code for a type system converter variable, like %CONVERTTOCPP[typeName].
+    QString converterTypeSystemVariable(TypeSystemConverterVariable converterVariable, const QString& typeName);
+    /// Replaces all the type system converter variables in a single pass over \p code.
+    void replaceConverterTypeSystemVariables(QString& code);
 
 private:
     bool m_useCtorHeuristic;
@@ -486,9 +601,62 @@ private:
     bool m_verboseErrorMessagesDisabled;
     bool m_useIsNullAsNbNonZero;
     bool m_avoidProtectedHack;
+    bool m_useLazyTypeInit;
+    int m_jobs;
+
+    friend class ClassGenerationJob;
+    void generateClassesInParallel();
+    bool m_generatingInParallel;
+    bool m_generatedInParallel;
+    QHash<const AbstractMetaClass*, QString> m_codeGeneratedInParallel;
+
+    bool m_skipUnchangedClasses;
+    bool m_useSharedConverters;
+    QString m_codeSizeReportFileName;
+    QString m_statisticsFileName;
+    int m_unityBuildFiles;
+    bool m_useTypeRegistrationTables;
+    enum AllowThreadPolicy {
+        AllowThreadAll,
+        AllowThreadHeuristic,
+        AllowThreadMarked
+    };
+    AllowThreadPolicy m_allowThreadPolicy;
+    QStringList m_allowThreadClasses;
+    bool m_useGilHoldDiagnostics;
+    bool m_useCallStatistics;
+    bool m_useStartupProfile;
+    QString m_generatorArguments;
+    /// Returns a hash of everything used to generate the code of \p metaClass.
+    QString classFingerprint(const AbstractMetaClass* metaClass);
+    bool classIsUnchanged(const AbstractMetaClass* metaClass);
+    QString classFingerprintFileName() const;
+    QString classOutputFileName(const AbstractMetaClass* metaClass) const;
+    bool m_classFingerprintsLoaded;
+    /// Fingerprints of the classes indexed by the name of their generated files.
+    QHash<QString, QString> m_classFingerprints;
+    /// Hash of the module wide part of the class fingerprints, computed on first use.
+    QString m_moduleFingerprint;
+    QHash<const AbstractMetaClass*, bool> m_unchangedClasses;
 
     typedef QHash<QString, AbstractMetaType*> AbstractMetaTypeCache;
     AbstractMetaTypeCache m_metaTypeFromStringCache;
+    QMutex m_metaTypeFromStringCacheMutex;
+
+    typedef QPair<const AbstractMetaClass*, QString> FunctionGroupKey;
+    QHash<FunctionGroupKey, OverloadDataList> m_overloadDataCache;
+    QHash<FunctionGroupKey, OverloadData*> m_functionGroupOverloadData;
+    QMutex m_overloadDataCacheMutex;
+    OverloadData& overloadDataFromCache(const AbstractMetaFunctionList& overloads);
+    /// Number of OverloadData requests answered from the cache.
+    int m_overloadDataCacheHits;
+    /// Time spent building OverloadData trees, in nanoseconds.
+    qint64 m_overloadDataBuildTime;
+
+    /// Returns the parsed template of \p code, parsing it only the first time.
+    CodeSnipTemplate codeSnipTemplate(const QString& code);
+    QHash<QString, CodeSnipTemplate> m_codeSnipTemplates;
+    QMutex m_codeSnipTemplatesMutex;
 
     /// Type system converter variable replacement names and regular expressions.
     QString m_typeSystemConvName[TypeSystemConverterVariables];
@@ -23,17 +23,25 @@
 #include "basewrapper.h"
 #include "basewrapper_p.h"
 #include "sbkenum.h"
+#include "sbkmodule.h"
+#include "sbkasync.h"
 #include "autodecref.h"
 #include "typeresolver.h"
 #include "gilstate.h"
+#include "sbktrace.h"
 #include <string>
 #include <cstring>
 #include <cstddef>
 #include <algorithm>
+#include <pythread.h>
 #include "threadstatesaver.h"
 
 namespace {
     void _destroyParentInfo(SbkObject* obj, bool keepReference);
+    std::size_t _instanceSize(PyTypeObject* type, int numBases);
+    void _countInstance(SbkObjectType* type, Py_ssize_t bytes);
+    // Types whose instances are counted, they are removed when the type is deallocated.
+    std::set<SbkObjectType*> countedTypes;
 }
 
 extern "C"
@@ -105,6 +113,16 @@ static PyGetSetDef SbkObjectGetSetList[] = {
     {0} // Sentinel
 };
 
+static PyObject* SbkObjectSizeOf(PyObject* self, PyObject*)
+{
+    return PyLong_FromSize_t(Shiboken::Object::sizeOf(reinterpret_cast<SbkObject*>(self)));
+}
+
+static PyMethodDef SbkObjectMethods[] = {
+    {const_cast<char*>("__sizeof__"), (PyCFunction)SbkObjectSizeOf, METH_NOARGS, 0},
+    {0} // Sentinel
+};
+
 static int SbkObject_traverse(PyObject* self, visitproc visit, void* arg)
 {
     SbkObject* sbkSelf = reinterpret_cast<SbkObject*>(self);
@@ -118,14 +136,11 @@ static int SbkObject_traverse(PyObject* self, visitproc visit, void* arg)
     }
 
     //Visit refs
-    Shiboken::RefCountMap* rInfo = sbkSelf->d->referredObjects;
+    Shiboken::RefCountList* rInfo = sbkSelf->d->referredObjects;
     if (rInfo) {
-        Shiboken::RefCountMap::const_iterator it = rInfo->begin();
-        for (; it != rInfo->end(); ++it) {
-            std::list<PyObject*>::const_iterator ref = it->second.begin();
-            for(; ref != it->second.end(); ++ref)
-                Py_VISIT(*ref);
-        }
+        Shiboken::RefCountList::const_iterator it = rInfo->begin();
+        for (; it != rInfo->end(); ++it)
+            Py_VISIT(it->object);
     }
 
     if (sbkSelf->ob_dict)
@@ -136,6 +151,7 @@ static int SbkObject_traverse(PyObject* self, visitproc visit, void* arg)
 static int SbkObject_clear(PyObject* self)
 {
     SbkObject* sbkSelf = reinterpret_cast<SbkObject*>(self);
+    Shiboken::DestructionBatch batch;
 
     Shiboken::Object::removeParent(sbkSelf);
 
@@ -177,7 +193,7 @@ SbkObjectType SbkObject_Type = { { {
     /*tp_weaklistoffset*/   offsetof(SbkObject, weakreflist),
     /*tp_iter*/             0,
     /*tp_iternext*/         0,
-    /*tp_methods*/          0,
+    /*tp_methods*/          SbkObjectMethods,
     /*tp_members*/          0,
     /*tp_getset*/           SbkObjectGetSetList,
     /*tp_base*/             0,
@@ -206,20 +222,21 @@ void SbkDeallocWrapper(PyObject* pyObj)
     if (sbkObj->weakreflist)
         PyObject_ClearWeakRefs(pyObj);
 
+    // The C++ object may have been destroyed by a thread without the GIL.
+    Shiboken::BindingManager::instance().processPendingInvalidations();
     // If I have ownership and is valid delete C++ pointer
     if (sbkObj->d->hasOwnership && sbkObj->d->validCppObject) {
+        // The C++ objects released along with this one are destroyed at once
+        Shiboken::DestructionBatch batch;
         SbkObjectType* sbkType = reinterpret_cast<SbkObjectType*>(pyObj->ob_type);
         if (sbkType->d->is_multicpp) {
             Shiboken::DtorCallerVisitor visitor(sbkObj);
             Shiboken::walkThroughClassHierarchy(pyObj->ob_type, &visitor);
         } else {
             void* cptr = sbkObj->d->cptr[0];
+            bool hasCppWrapper = sbkObj->d->containsCppWrapper;
             Shiboken::Object::deallocData(sbkObj, true);
-
-            Shiboken::ThreadStateSaver threadSaver;
-            if (Py_IsInitialized())
-                threadSaver.save();
-            sbkType->d->cpp_dtor(cptr);
+            Shiboken::DestructionBatch::destroy(sbkType, cptr, hasCppWrapper);
         }
     } else {
         Shiboken::Object::deallocData(sbkObj, true);
@@ -232,6 +249,7 @@ void SbkDeallocWrapperWithPrivateDtor(PyObject* self)
     if (sbkObj->weakreflist)
         PyObject_ClearWeakRefs(self);
 
+    Shiboken::BindingManager::instance().processPendingInvalidations();
     Shiboken::Object::deallocData(sbkObj, true);
 }
 
@@ -248,6 +266,8 @@ void SbkObjectTypeDealloc(PyObject* pyObj)
         }
         free(sbkType->d->original_name);
         sbkType->d->original_name = 0;
+        if (sbkType->d->is_counted)
+            countedTypes.erase(sbkType);
         delete sbkType->d;
         sbkType->d = 0;
     }
@@ -299,6 +319,7 @@ PyObject* SbkObjectTypeTpNew(PyTypeObject* metatype, PyObject* args, PyObject* k
         d->ext_tocpp = parentType->ext_tocpp;
         d->type_discovery = parentType->type_discovery;
         d->cpp_dtor = parentType->cpp_dtor;
+        d->threadsafe_dtor = parentType->threadsafe_dtor;
         d->is_multicpp = 0;
     } else {
         d->mi_offsets = 0;
@@ -308,6 +329,7 @@ PyObject* SbkObjectTypeTpNew(PyTypeObject* metatype, PyObject* args, PyObject* k
         d->ext_tocpp = 0;
         d->type_discovery = 0;
         d->cpp_dtor = 0;
+        d->threadsafe_dtor = 0;
         d->is_multicpp = 1;
     }
     if (bases.size() == 1)
@@ -346,6 +368,9 @@ PyObject* SbkObjectTpNew(PyTypeObject* subtype, PyObject*, PyObject*)
     self->ob_dict = 0;
     self->weakreflist = 0;
     self->d = d;
+    if (sbkType->d)
+        _countInstance(sbkType, _instanceSize(subtype, numBases));
+    Shiboken::Trace::event(Shiboken::Trace::WrapperCreated, self, subtype->tp_name);
     PyObject_GC_Track(reinterpret_cast<PyObject*>(self));
     return reinterpret_cast<PyObject*>(self);
 }
@@ -361,6 +386,7 @@ void _destroyParentInfo(SbkObject* obj, bool keepReference)
 {
     Shiboken::ParentInfo* pInfo = obj->d->parentInfo;
     if (pInfo) {
+        Shiboken::DestructionBatch batch;
         while(!pInfo->children.empty()) {
             SbkObject* first = *pInfo->children.begin();
             // Mark child as invalid
@@ -371,12 +397,36 @@ void _destroyParentInfo(SbkObject* obj, bool keepReference)
     }
 }
 
+// Memory allocated by SbkObjectTpNew for an instance of \p type holding \p numBases C++ pointers.
+std::size_t _instanceSize(PyTypeObject* type, int numBases)
+{
+    return type->tp_basicsize + sizeof(SbkObjectPrivate) + numBases * sizeof(void*);
+}
+
+void _countInstance(SbkObjectType* type, Py_ssize_t bytes)
+{
+    if (!type->d->is_counted) {
+        countedTypes.insert(type);
+        type->d->is_counted = 1;
+    }
+    type->d->live_instances += bytes > 0 ? 1 : -1;
+    type->d->live_bytes += bytes;
+}
+
+// Memory taken by a node of the std::set and std::map used by ParentInfo: the value
+// plus the color, parent, left and right fields of the tree node.
+template<typename T>
+inline std::size_t _treeNodeSize()
+{
+    return sizeof(T) + 4 * sizeof(void*);
+}
+
 }
 
 namespace Shiboken
 {
 
-static void decRefPyObjectList(const std::list<PyObject*> &pyObj, PyObject* skip = 0);
+static void decRefPyObjectList(const std::vector<PyObject*>& lst);
 
 static void _walkThroughClassHierarchy(PyTypeObject* currentType, HierarchyVisitor* visitor)
 {
@@ -435,6 +485,188 @@ bool importModule(const char* moduleName, PyTypeObject*** cppApiPtr)
     return true;
 }
 
+// Deferred destruction of C++ objects ----------------------------------------------------------
+
+typedef std::pair<ObjectDestructor, void*> PendingDestruction;
+typedef std::list<PendingDestruction> PendingDestructionList;
+
+// PyThread_get_thread_ident returns a long on Python 2 and an unsigned long on Python 3.
+static inline unsigned long currentThreadIdent()
+{
+    return static_cast<unsigned long>(PyThread_get_thread_ident());
+}
+
+// Objects queued by the active DestructionBatch, protected by the GIL.
+static PendingDestructionList batchQueue;
+static int batchDepth = 0;
+static unsigned long batchThread = 0;
+
+// Objects waiting for the destructor thread, protected by destructorThreadMutex.
+static PendingDestructionList destructorThreadQueue;
+static PyThread_type_lock destructorThreadMutex = 0;
+// Released each time the destructor thread queue stops being empty, or when the thread must stop.
+static PyThread_type_lock destructorThreadWakeUp = 0;
+// Released by the destructor thread when it finishes.
+static PyThread_type_lock destructorThreadFinished = 0;
+// Set with destructorThreadMutex held, the thread finishes after destroying the objects already queued.
+static bool destructorThreadStopping = false;
+// Zero if the destructor thread was not started yet, negative if it couldn't be started or was stopped.
+static int destructorThreadState = 0;
+
+static void callDestructors(const PendingDestructionList& pending)
+{
+    PendingDestructionList::const_iterator it = pending.begin();
+    for (; it != pending.end(); ++it)
+        it->first(it->second);
+}
+
+static PendingDestructionList takeDestructorThreadQueue(bool* stopping)
+{
+    PendingDestructionList pending;
+    PyThread_acquire_lock(destructorThreadMutex, WAIT_LOCK);
+    pending.swap(destructorThreadQueue);
+    *stopping = destructorThreadStopping;
+    PyThread_release_lock(destructorThreadMutex);
+    return pending;
+}
+
+static void destructorThreadMain(void*)
+{
+    bool stopping = false;
+    while (!stopping) {
+        PyThread_acquire_lock(destructorThreadWakeUp, WAIT_LOCK);
+        callDestructors(takeDestructorThreadQueue(&stopping));
+    }
+    PyThread_release_lock(destructorThreadFinished);
+}
+
+// Called by the atexit module, before the interpreter finalization, with the GIL held.
+static void stopDestructorThread()
+{
+    if (destructorThreadState <= 0)
+        return;
+    // From now on objects are destroyed by the thread releasing them.
+    destructorThreadState = -1;
+
+    PyThread_acquire_lock(destructorThreadMutex, WAIT_LOCK);
+    destructorThreadStopping = true;
+    // A non empty queue means the thread was already woken up.
+    bool wasEmpty = destructorThreadQueue.empty();
+    PyThread_release_lock(destructorThreadMutex);
+    if (wasEmpty)
+        PyThread_release_lock(destructorThreadWakeUp);
+
+    ThreadStateSaver threadSaver;
+    threadSaver.save();
+    PyThread_acquire_lock(destructorThreadFinished, WAIT_LOCK);
+}
+
+static bool startDestructorThread()
+{
+    destructorThreadState = -1;
+    destructorThreadMutex = PyThread_allocate_lock();
+    destructorThreadWakeUp = PyThread_allocate_lock();
+    destructorThreadFinished = PyThread_allocate_lock();
+    if (!destructorThreadMutex || !destructorThreadWakeUp || !destructorThreadFinished)
+        return false;
+
+    // The thread is stopped before the interpreter finalization, or it's not started at all.
+    if (!callAtExit(stopDestructorThread))
+        return false;
+
+    PyThread_acquire_lock(destructorThreadWakeUp, WAIT_LOCK);
+    PyThread_acquire_lock(destructorThreadFinished, WAIT_LOCK);
+    if (long(PyThread_start_new_thread(destructorThreadMain, 0)) == -1)
+        return false;
+
+    destructorThreadState = 1;
+    return true;
+}
+
+struct ExitFunction
+{
+    void (*function)();
+};
+
+static PyObject* callExitFunction(PyObject* self, PyObject*)
+{
+    reinterpret_cast<ExitFunction*>(PyLong_AsVoidPtr(self))->function();
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef exitFunctionDef = {
+    const_cast<char*>("_shibokenExitFunction"), (PyCFunction)callExitFunction, METH_NOARGS, 0
+};
+
+bool callAtExit(void (*function)())
+{
+    ExitFunction* exitFunction = new ExitFunction;
+    exitFunction->function = function;
+    AutoDecRef self(PyLong_FromVoidPtr(exitFunction));
+    AutoDecRef atexit(PyImport_ImportModule("atexit"));
+    AutoDecRef callable((self.isNull() || atexit.isNull()) ? 0 : PyCFunction_New(&exitFunctionDef, self));
+    AutoDecRef result(callable.isNull() ? 0 : PyObject_CallMethod(atexit, const_cast<char*>("register"),
+                                                                   const_cast<char*>("O"), callable.object()));
+    if (result.isNull()) {
+        PyErr_Clear();
+        return false;
+    }
+    return true;
+}
+
+DestructionBatch::DestructionBatch() : m_active(false)
+{
+    unsigned long thread = currentThreadIdent();
+    if (batchDepth == 0)
+        batchThread = thread;
+    else if (batchThread != thread) // The current batch belongs to another thread
+        return;
+    ++batchDepth;
+    m_active = true;
+}
+
+DestructionBatch::~DestructionBatch()
+{
+    if (!m_active || --batchDepth > 0 || batchQueue.empty())
+        return;
+
+    // Other threads may start a new batch while the GIL is released
+    PendingDestructionList pending;
+    pending.swap(batchQueue);
+
+    ThreadStateSaver threadSaver;
+    if (Py_IsInitialized())
+        threadSaver.save();
+    callDestructors(pending);
+}
+
+void DestructionBatch::destroy(SbkObjectType* type, void* cptr, bool hasCppWrapper)
+{
+    ObjectDestructor dtor = type->d->cpp_dtor;
+
+    // C++ wrappers need the interpreter on destruction, so they can't use the destructor thread.
+    if (type->d->threadsafe_dtor && !hasCppWrapper
+        && (destructorThreadState > 0 || (destructorThreadState == 0 && startDestructorThread()))) {
+        PyThread_acquire_lock(destructorThreadMutex, WAIT_LOCK);
+        bool wasEmpty = destructorThreadQueue.empty();
+        destructorThreadQueue.push_back(PendingDestruction(dtor, cptr));
+        PyThread_release_lock(destructorThreadMutex);
+        if (wasEmpty)
+            PyThread_release_lock(destructorThreadWakeUp);
+        return;
+    }
+
+    if (batchDepth > 0 && batchThread == currentThreadIdent()) {
+        batchQueue.push_back(PendingDestruction(dtor, cptr));
+        return;
+    }
+
+    ThreadStateSaver threadSaver;
+    if (Py_IsInitialized())
+        threadSaver.save();
+    dtor(cptr);
+}
+
 // Wrapper metatype and base type ----------------------------------------------------------
 
 void DtorCallerVisitor::visit(SbkObjectType* node)
@@ -444,14 +676,14 @@ void DtorCallerVisitor::visit(SbkObjectType* node)
 
 void DtorCallerVisitor::done()
 {
+    bool hasCppWrapper = m_pyObj->d->containsCppWrapper;
+    // All the C++ instances are destroyed with a single GIL release.
+    DestructionBatch batch;
     Shiboken::Object::deallocData(m_pyObj, true);
 
     std::list<std::pair<void*, SbkObjectType*> >::const_iterator it = m_ptrs.begin();
-    for (; it != m_ptrs.end(); ++it) {
-        Shiboken::ThreadStateSaver threadSaver;
-        threadSaver.save();
-        it->second->d->cpp_dtor(it->first);
-    }
+    for (; it != m_ptrs.end(); ++it)
+        DestructionBatch::destroy(it->second, it->first, hasCppWrapper);
 }
 
 namespace Module { void init(); }
@@ -463,6 +695,7 @@ void init()
         return;
 
     Module::init();
+    Trace::init();
 
     initTypeResolver();
     PyEval_InitThreads();
@@ -479,6 +712,9 @@ void init()
     if (PyType_Ready((PyTypeObject *)&SbkObject_Type) < 0)
         Py_FatalError("[libshiboken] Failed to initialise Shiboken.BaseWrapper type.");
 
+    if (PyType_Ready(&SbkFuture_Type) < 0)
+        Py_FatalError("[libshiboken] Failed to initialise Shiboken.Future type.");
+
     shibokenAlreadInitialised = true;
 }
 
@@ -556,14 +792,11 @@ std::list<SbkObject*> splitPyObject(PyObject* pyObj)
     return result;
 }
 
-static void decRefPyObjectList(const std::list<PyObject*>& lst, PyObject *skip)
+static void decRefPyObjectList(const std::vector<PyObject*>& lst)
 {
-    std::list<PyObject*>::const_iterator iter = lst.begin();
-    while(iter != lst.end()) {
-        if (*iter != skip)
-            Py_DECREF(*iter);
-        ++iter;
-    }
+    std::vector<PyObject*>::const_iterator iter = lst.begin();
+    for (; iter != lst.end(); ++iter)
+        Py_DECREF(*iter);
 }
 
 namespace ObjectType
@@ -681,6 +914,11 @@ void setDestructorFunction(SbkObjectType* self, ObjectDestructor func)
     self->d->cpp_dtor = func;
 }
 
+void setThreadSafeDestructor(SbkObjectType* self, bool threadSafe)
+{
+    self->d->threadsafe_dtor = threadSafe;
+}
+
 void initPrivateData(SbkObjectType* self)
 {
     self->d = new SbkObjectTypePrivate;
@@ -719,6 +957,65 @@ bool introduceWrapperType(PyObject* enclosingObject,
     return PyModule_AddObject(enclosingObject, typeName, (PyObject*)type) == 0;
 }
 
+static inline SbkObjectType* resolveTypeReference(const TypeReference& ref)
+{
+    return reinterpret_cast<SbkObjectType*>((*ref.types)[ref.index]);
+}
+
+bool introduceWrapperTypes(PyObject* module, PyTypeObject** types, const TypeDescription* const* table, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const TypeDescription* desc = table[i];
+        SbkObjectType* type = desc->type;
+        types[desc->index] = reinterpret_cast<PyTypeObject*>(type);
+        if (desc->prepare)
+            desc->prepare();
+
+        bool isInnerClass = desc->enclosingType.types != 0;
+        PyObject* enclosingObject = isInnerClass ? resolveTypeReference(desc->enclosingType)->super.ht_type.tp_dict : module;
+
+        SbkObjectType* baseType = 0;
+        PyObject* baseTypes = 0;
+        if (desc->baseType.types)
+            baseType = resolveTypeReference(desc->baseType);
+        if (desc->baseTypes) {
+            int baseCount = 0;
+            while (desc->baseTypes[baseCount].types)
+                ++baseCount;
+            baseTypes = PyTuple_New(baseCount);
+            if (!baseTypes)
+                return false;
+            for (int j = 0; j < baseCount; ++j) {
+                PyObject* base = reinterpret_cast<PyObject*>(resolveTypeReference(desc->baseTypes[j]));
+                Py_INCREF(base);
+                PyTuple_SET_ITEM(baseTypes, j, base);
+            }
+        }
+
+        if (!introduceWrapperType(enclosingObject, desc->typeName, desc->originalName, type,
+                                  desc->cppObjDtor, baseType, baseTypes, isInnerClass)) {
+            return false;
+        }
+
+        if (desc->mi_init || desc->mi_class.types) {
+            MultipleInheritanceInitFunction func = desc->mi_init;
+            if (!func)
+                func = getMultipleIheritanceFunction(resolveTypeReference(desc->mi_class));
+            setMultipleIheritanceFunction(type, func);
+            setCastFunction(type, desc->castFunction);
+        }
+        if (desc->typeDiscovery)
+            setTypeDiscoveryFunctionV2(type, desc->typeDiscovery);
+
+        if (desc->finish) {
+            desc->finish(enclosingObject);
+            if (PyErr_Occurred())
+                return false;
+        }
+    }
+    return true;
+}
+
 void setSubTypeInitHook(SbkObjectType* self, SubTypeInitHook func)
 {
     self->d->subtype_init = func;
@@ -735,6 +1032,27 @@ void setTypeUserData(SbkObjectType* self, void* userData, DeleteUserDataFunc d_f
     self->d->d_func = d_func;
 }
 
+PyObject* instanceHistogram()
+{
+    PyObject* histogram = PyDict_New();
+    if (!histogram)
+        return 0;
+    std::set<SbkObjectType*>::const_iterator it = countedTypes.begin();
+    for (; it != countedTypes.end(); ++it) {
+        SbkObjectTypePrivate* d = (*it)->d;
+        if (!d->live_instances)
+            continue;
+        PyObject* counters = Py_BuildValue("(nn)", d->live_instances, d->live_bytes);
+        if (!counters || PyDict_SetItem(histogram, reinterpret_cast<PyObject*>(*it), counters) < 0) {
+            Py_XDECREF(counters);
+            Py_DECREF(histogram);
+            return 0;
+        }
+        Py_DECREF(counters);
+    }
+    return histogram;
+}
+
 } // namespace ObjectType
 
 
@@ -802,6 +1120,7 @@ void getOwnership(SbkObject* self)
 
     // Get back the ownership
     self->d->hasOwnership = true;
+    Trace::event(Trace::OwnershipTransferred, self, "Python");
 
     if (self->d->containsCppWrapper)
         Py_DECREF((PyObject*) self); // Remove extra ref
@@ -824,6 +1143,7 @@ void releaseOwnership(SbkObject* self)
 
     // remove object ownership
     self->d->hasOwnership = false;
+    Trace::event(Trace::OwnershipTransferred, self, "C++");
 
     // If We have control over object life
     if (self->d->containsCppWrapper)
@@ -874,16 +1194,10 @@ void invalidate(SbkObject* self)
 
     // If has ref to other objects invalidate all
     if (self->d->referredObjects) {
-        RefCountMap& refCountMap = *(self->d->referredObjects);
-        RefCountMap::iterator iter;
-        for (iter = refCountMap.begin(); iter != refCountMap.end(); ++iter) {
-            const std::list<PyObject*> lst = iter->second;
-            std::list<PyObject*>::const_iterator it = lst.begin();
-            while(it != lst.end()) {
-                invalidate(*it);
-                ++it;
-            }
-        }
+        // Use indexes because this list can be changed during the process
+        RefCountList& refs = *(self->d->referredObjects);
+        for (std::size_t i = 0; i < refs.size(); ++i)
+            invalidate(refs[i].object);
     }
 }
 
@@ -905,16 +1219,10 @@ void makeValid(SbkObject* self)
 
     // If has ref to other objects make all valid again
     if (self->d->referredObjects) {
-        RefCountMap& refCountMap = *(self->d->referredObjects);
-        RefCountMap::iterator iter;
-        for (iter = refCountMap.begin(); iter != refCountMap.end(); ++iter) {
-            const std::list<PyObject*> lst = iter->second;
-            std::list<PyObject*>::const_iterator it = lst.begin();
-            while(it != lst.end()) {
-                if (Shiboken::Object::checkType(*it))
-                    makeValid(reinterpret_cast<SbkObject*>(*it));
-                ++it;
-            }
+        RefCountList& refs = *(self->d->referredObjects);
+        for (std::size_t i = 0; i < refs.size(); ++i) {
+            if (Shiboken::Object::checkType(refs[i].object))
+                makeValid(reinterpret_cast<SbkObject*>(refs[i].object));
         }
     }
 }
@@ -965,6 +1273,8 @@ bool isValid(PyObject* pyObj)
         return false;
     }
 
+    // The C++ object may have been destroyed by another thread.
+    BindingManager::instance().processPendingInvalidations();
     if (!priv->validCppObject) {
         PyErr_Format(PyExc_RuntimeError, "Internal C++ object (%s) already deleted.", pyObj->ob_type->tp_name);
         return false;
@@ -985,6 +1295,7 @@ bool isValid(SbkObject* pyObj, bool throwPyError)
         return false;
     }
 
+    BindingManager::instance().processPendingInvalidations();
     if (!priv->validCppObject) {
         if (throwPyError)
             PyErr_Format(PyExc_RuntimeError, "Internal C++ object (%s) already deleted.", Py_TYPE(pyObj)->tp_name);
@@ -1011,6 +1322,9 @@ PyObject* newObject(SbkObjectType* instanceType,
 {
     // Try to find the exact type of cptr.
     if (!isExactType) {
+        // Lazy subtypes register their type resolvers and inheritance only when initialized.
+        if (!Module::loadLazySubTypes(reinterpret_cast<PyTypeObject*>(instanceType)))
+            return 0;
         TypeResolver* tr = 0;
         if (typeName) {
             tr = TypeResolver::get(typeName);
@@ -1029,6 +1343,27 @@ PyObject* newObject(SbkObjectType* instanceType,
     return reinterpret_cast<PyObject*>(self);
 }
 
+PyObject* fieldView(SbkObject* owner, SbkObjectType* instanceType, void* cptr)
+{
+    ParentInfo* pInfo = owner->d->parentInfo;
+    if (pInfo) {
+        FieldViewMap::iterator it = pInfo->fieldViews.find(cptr);
+        if (it != pInfo->fieldViews.end()) {
+            SbkObject* view = it->second;
+            if (Py_TYPE(view) == reinterpret_cast<PyTypeObject*>(instanceType) && view->d->validCppObject) {
+                Py_INCREF(reinterpret_cast<PyObject*>(view));
+                return reinterpret_cast<PyObject*>(view);
+            }
+            pInfo->fieldViews.erase(it);
+        }
+    }
+
+    PyObject* view = newObject(instanceType, cptr, false, true);
+    setParent(reinterpret_cast<PyObject*>(owner), view);
+    owner->d->parentInfo->fieldViews[cptr] = reinterpret_cast<SbkObject*>(view);
+    return view;
+}
+
 void destroy(SbkObject* self)
 {
     destroy(self, 0);
@@ -1043,6 +1378,9 @@ void destroy(SbkObject* self, void* cppData)
     // This can be called in c++ side
     Shiboken::GilState gil;
 
+    // Other objects destroyed without the GIL, like the children of this one, are invalidated first.
+    Shiboken::BindingManager::instance().processPendingInvalidations();
+
     // Remove all references attached to this object
     clearReferences(self);
 
@@ -1097,6 +1435,18 @@ void removeParent(SbkObject* child, bool giveOwnershipBack, bool keepReference)
 
     oldBrothers.erase(iChild);
 
+    // Forget the child if it was a view of a field of its parent
+    FieldViewMap& fieldViews = pInfo->parent->d->parentInfo->fieldViews;
+    if (!fieldViews.empty()) {
+        FieldViewMap::iterator iView = fieldViews.begin();
+        for (; iView != fieldViews.end(); ++iView) {
+            if (iView->second == child) {
+                fieldViews.erase(iView);
+                break;
+            }
+        }
+    }
+
     pInfo->parent = 0;
 
     // This will keep the wrapper reference, will wait for wrapper destruction to remove that
@@ -1161,6 +1511,7 @@ void setParent(PyObject* parent, PyObject* child)
 
     //Avoid destroy child during reparent operation
     Py_INCREF(child);
+    Trace::event(Trace::ParentSet, child, Py_TYPE(child)->tp_name, parentIsNull ? 0 : parent);
 
     // check if we need to remove this child from the old parent
     if (parentIsNull || hasAnotherParent)
@@ -1198,6 +1549,13 @@ void deallocData(SbkObject* self, bool cleanup)
         clearReferences(self);
     }
 
+    Trace::event(Trace::WrapperDestroyed, self, Py_TYPE(self)->tp_name);
+    SbkObjectType* sbkType = reinterpret_cast<SbkObjectType*>(Py_TYPE(self));
+    if (sbkType->d) {
+        int numBases = sbkType->d->is_multicpp ? getNumberOfCppBaseClasses(Py_TYPE(self)) : 1;
+        _countInstance(sbkType, -Py_ssize_t(_instanceSize(Py_TYPE(self), numBases)));
+    }
+
     if (self->d->cptr) {
         // Remove from BindingManager
         Shiboken::BindingManager::instance().releaseWrapper(self);
@@ -1224,44 +1582,111 @@ void* getTypeUserData(SbkObject* wrapper)
     return reinterpret_cast<SbkObjectType*>(Py_TYPE(wrapper))->d->user_data;
 }
 
+std::size_t sizeOf(SbkObject* self)
+{
+    SbkObjectType* sbkType = reinterpret_cast<SbkObjectType*>(Py_TYPE(self));
+    int numBases = (sbkType->d && sbkType->d->is_multicpp) ? getNumberOfCppBaseClasses(Py_TYPE(self)) : 1;
+    std::size_t size = _instanceSize(Py_TYPE(self), numBases);
+
+    ParentInfo* pInfo = self->d->parentInfo;
+    if (pInfo) {
+        size += sizeof(ParentInfo);
+        size += pInfo->children.size() * _treeNodeSize<ChildrenList::value_type>();
+        size += pInfo->fieldViews.size() * _treeNodeSize<FieldViewMap::value_type>();
+    }
+    RefCountList* referredObjects = self->d->referredObjects;
+    if (referredObjects)
+        size += sizeof(RefCountList) + referredObjects->capacity() * sizeof(KeptReference);
+    if (self->d->cptr)
+        size += BindingManager::instance().wrapperMapUsage(self);
+    return size;
+}
+
+int referenceSlot(const char* key)
+{
+    typedef std::map<std::string, int> SlotMap;
+    static SlotMap slots;
+    SlotMap::iterator it = slots.find(key);
+    if (it != slots.end())
+        return it->second;
+    int slot = int(slots.size());
+    slots.insert(std::make_pair(std::string(key), slot));
+    return slot;
+}
+
 void keepReference(SbkObject* self, const char* key, PyObject* referredObject, bool append)
 {
-    bool isNone = (!referredObject || (referredObject == Py_None));
+    keepReference(self, referenceSlot(key), referredObject, append);
+}
 
-    if (!self->d->referredObjects)
-        self->d->referredObjects = new Shiboken::RefCountMap;
+void keepReference(SbkObject* self, int slot, PyObject* referredObject, bool append)
+{
+    bool isNone = (!referredObject || (referredObject == Py_None));
 
-    RefCountMap& refCountMap = *(self->d->referredObjects);
-    RefCountMap::iterator iter = refCountMap.find(key);
-    std::list<PyObject*> objects;
-    if (iter != refCountMap.end()) {
-        objects = (*iter).second;
-        std::list<PyObject*>::const_iterator found = std::find(objects.begin(), objects.end(), referredObject);
+    if (!self->d->referredObjects) {
+        if (isNone)
+            return;
+        self->d->referredObjects = new Shiboken::RefCountList;
+    }
 
+    RefCountList& refs = *(self->d->referredObjects);
+    int inSlot = 0;
+    RefCountList::iterator lastInSlot = refs.end();
+    for (RefCountList::iterator it = refs.begin(); it != refs.end(); ++it) {
+        if (it->slot != slot)
+            continue;
         // skip if objects already exists
-        if (found != objects.end())
+        if (it->object == referredObject)
             return;
+        ++inSlot;
+        lastInSlot = it;
     }
 
-    if (append && !isNone) {
-        refCountMap[key].push_back(referredObject);
-        Py_INCREF(referredObject);
-    } else if (!append) {
-        if (objects.size() > 0)
-            decRefPyObjectList(objects, isNone ? 0 : referredObject);
-        if (isNone) {
-            if (iter != refCountMap.end())
-                refCountMap.erase(iter);
-        } else {
-            objects.clear();
-            objects.push_back(referredObject);
-            refCountMap[key] = objects;
+    if (append) {
+        if (!isNone) {
+            refs.push_back(KeptReference(slot, referredObject));
             Py_INCREF(referredObject);
         }
+        return;
+    }
+
+    if (inSlot == 1 && !isNone) {
+        // A setter called again, just replace the previous object
+        PyObject* previous = lastInSlot->object;
+        lastInSlot->object = referredObject;
+        Py_INCREF(referredObject);
+        Py_DECREF(previous);
+        return;
+    }
+
+    // The replaced objects are released after the list is updated, because
+    // their destruction can run code that changes the list again.
+    std::vector<PyObject*> released;
+    if (inSlot) {
+        released.reserve(inSlot);
+        RefCountList::iterator out = refs.begin();
+        for (RefCountList::iterator it = refs.begin(); it != refs.end(); ++it) {
+            if (it->slot == slot)
+                released.push_back(it->object);
+            else
+                *out++ = *it;
+        }
+        refs.erase(out, refs.end());
+    }
+
+    if (!isNone) {
+        refs.push_back(KeptReference(slot, referredObject));
+        Py_INCREF(referredObject);
     }
+    decRefPyObjectList(released);
 }
 
 void removeReference(SbkObject* self, const char* key, PyObject* referredObject)
+{
+    removeReference(self, referenceSlot(key), referredObject);
+}
+
+void removeReference(SbkObject* self, int slot, PyObject* referredObject)
 {
     if (!referredObject || (referredObject == Py_None))
         return;
@@ -1269,12 +1694,17 @@ void removeReference(SbkObject* self, const char* key, PyObject* referredObject)
     if (!self->d->referredObjects)
         return;
 
-    RefCountMap& refCountMap = *(self->d->referredObjects);
-    RefCountMap::iterator iter = refCountMap.find(key);
-    if (iter != refCountMap.end()) {
-        decRefPyObjectList(iter->second);
-        refCountMap.erase(iter);
+    RefCountList& refs = *(self->d->referredObjects);
+    std::vector<PyObject*> released;
+    RefCountList::iterator out = refs.begin();
+    for (RefCountList::iterator it = refs.begin(); it != refs.end(); ++it) {
+        if (it->slot == slot)
+            released.push_back(it->object);
+        else
+            *out++ = *it;
     }
+    refs.erase(out, refs.end());
+    decRefPyObjectList(released);
 }
 
 void clearReferences(SbkObject* self)
@@ -1282,12 +1712,13 @@ void clearReferences(SbkObject* self)
     if (!self->d->referredObjects)
         return;
 
-    RefCountMap& refCountMap = *(self->d->referredObjects);
-    RefCountMap::iterator iter;
-    for (iter = refCountMap.begin(); iter != refCountMap.end(); ++iter)
-        decRefPyObjectList(iter->second);
-    delete self->d->referredObjects;
+    RefCountList* refs = self->d->referredObjects;
     self->d->referredObjects = 0;
+
+    RefCountList::const_iterator it = refs->begin();
+    for (; it != refs->end(); ++it)
+        Py_DECREF(it->object);
+    delete refs;
 }
 
 } // namespace Object
@@ -165,6 +165,12 @@ LIBSHIBOKEN_API void        setMultipleIheritanceFunction(SbkObjectType* self, M
 LIBSHIBOKEN_API MultipleInheritanceInitFunction getMultipleIheritanceFunction(SbkObjectType* self);
 
 LIBSHIBOKEN_API void        setDestructorFunction(SbkObjectType* self, ObjectDestructor func);
+/**
+ *  Tells if the destructor of the C++ class represented by \p self can run in any thread, without
+ *  the GIL and in parallel with the interpreter. Instances of such types owned by Python are
+ *  destroyed by a background thread instead of blocking the thread releasing the last reference.
+ */
+LIBSHIBOKEN_API void        setThreadSafeDestructor(SbkObjectType* self, bool threadSafe);
 
 LIBSHIBOKEN_API void        initPrivateData(SbkObjectType* self);
 
@@ -191,6 +197,56 @@ LIBSHIBOKEN_API bool        introduceWrapperType(PyObject* enclosingObject,
                                                  SbkObjectType* baseType = 0, PyObject* baseTypes = 0,
                                                  bool isInnerClass = false);
 
+/// Reference to a wrapper type by its index in the type array of a module.
+struct TypeReference
+{
+    /// Address of the module's type array variable, e.g. SbkSampleTypes; null means no type.
+    PyTypeObject*** types;
+    int index;
+};
+
+/**
+ *  Constant description of a wrapper type, used by introduceWrapperTypes to register
+ *  a whole module from static tables instead of per-class initialization code.
+ */
+struct TypeDescription
+{
+    /// Name by which the type will be known in Python.
+    const char* typeName;
+    /// Original C++ name of the type.
+    const char* originalName;
+    SbkObjectType* type;
+    /// Index of \p type in the type array of its module.
+    int index;
+    /// Enclosing class of an inner class, the type is added to the module if this is empty.
+    TypeReference enclosingType;
+    ObjectDestructor cppObjDtor;
+    TypeReference baseType;
+    /// All the base types of a class with multiple inheritance, terminated by an empty reference.
+    const TypeReference* baseTypes;
+    /// Called before the type is made ready, used to set up the number, sequence and mapping protocols.
+    void (*prepare)();
+    MultipleInheritanceInitFunction mi_init;
+    /// Class from which the multiple inheritance initializer is taken when \p mi_init is null.
+    TypeReference mi_class;
+    SpecialCastFunction castFunction;
+    TypeDiscoveryFuncV2 typeDiscovery;
+    /// Called with the module or the enclosing class after the type was introduced.
+    void (*finish)(PyObject* enclosingObject);
+};
+
+/**
+ *  Introduces all the wrapper types described by \p table, in order, as introduceWrapperType
+ *  would do for each one of them, storing each type in \p types at its index.
+ *  \param module   The module being initialized.
+ *  \param types    The type array of the module.
+ *  \param table    Descriptions of the types, enclosing classes and bases come before the types that use them.
+ *  \param count    Number of entries in \p table.
+ *  \returns        true if all the types were introduced, false otherwise.
+ */
+LIBSHIBOKEN_API bool        introduceWrapperTypes(PyObject* module, PyTypeObject** types,
+                                                  const TypeDescription* const* table, int count);
+
 /**
  *  Set the subtype init hook for a type.
  *
@@ -205,6 +261,14 @@ LIBSHIBOKEN_API void        setSubTypeInitHook(SbkObjectType* self, SubTypeInitH
  */
 LIBSHIBOKEN_API void*       getTypeUserData(SbkObjectType* self);
 LIBSHIBOKEN_API void        setTypeUserData(SbkObjectType* self, void* userData, DeleteUserDataFunc d_func);
+
+/**
+ *  Returns a new dictionary mapping each wrapper type with live instances to a tuple with the number
+ *  of instances and the bytes allocated for them by the binding, not counting the C++ objects nor
+ *  the structures that grow with the use of each instance, see Object::sizeOf.
+ *  Instances are counted by their exact type, not by their base types.
+ */
+LIBSHIBOKEN_API PyObject*   instanceHistogram();
 }
 
 namespace Object {
@@ -234,6 +298,17 @@ LIBSHIBOKEN_API PyObject*   newObject(SbkObjectType* instanceType,
                                       bool isExactType = false,
                                       const char* typeName = 0);
 
+/**
+ *  Returns a wrapper for a value-type field that lives inside the memory of \p owner.
+ *  The wrapper is created on the first access and kept as a child of \p owner, later
+ *  accesses to the same field return the same Python object. It is invalidated when the owner dies.
+ * \param owner         the wrapper of the object that contains the field.
+ * \param instanceType  equivalent Python type for the field.
+ * \param cptr          address of the field.
+ * \returns a new reference to the field wrapper.
+ */
+LIBSHIBOKEN_API PyObject*   fieldView(SbkObject* owner, SbkObjectType* instanceType, void* cptr);
+
 /**
  *  Changes the valid flag of a PyObject, invalid objects will raise an exception when someone tries to access it.
  */
@@ -364,6 +439,21 @@ LIBSHIBOKEN_API void        setTypeUserData(SbkObject* wrapper, void* userData,
  */
 LIBSHIBOKEN_API void*       getTypeUserData(SbkObject* wrapper);
 
+/**
+ *  Returns the memory used by the binding for \p self: the wrapper object, its private data, the
+ *  C++ pointers, the parent and children information, the kept references and the entries of the
+ *  wrapper map, including the ones for the addresses of the bases with multiple inheritance.
+ *  The C++ object itself and the instance dictionary are not counted. It's used by __sizeof__.
+ */
+LIBSHIBOKEN_API std::size_t sizeOf(SbkObject* self);
+
+/**
+ *   Returns the slot identifying the method and argument described by \p key, to be used with
+ *   keepReference and removeReference. The same key always gives the same slot, so generated
+ *   code can look it up once and reuse it on later calls.
+ */
+LIBSHIBOKEN_API int         referenceSlot(const char* key);
+
 /**
  *   Increments the reference count of the referred Python object.
  *   A previous Python object in the same position identified by the 'key' parameter
@@ -377,6 +467,8 @@ LIBSHIBOKEN_API void*       getTypeUserData(SbkObject* wrapper);
  *   \param referredObject  the object whose reference is used by the self object.
  */
 LIBSHIBOKEN_API void        keepReference(SbkObject* self, const char* key, PyObject* referredObject, bool append = false);
+/// Same as keepReference(SbkObject*, const char*, PyObject*, bool) using a slot given by referenceSlot.
+LIBSHIBOKEN_API void        keepReference(SbkObject* self, int slot, PyObject* referredObject, bool append = false);
 
 /**
  *   Removes any reference previously added by keepReference function
@@ -385,6 +477,8 @@ LIBSHIBOKEN_API void        keepReference(SbkObject* self, const char* key, PyOb
  *   \param referredObject  the object whose reference is used by the self object.
  */
 LIBSHIBOKEN_API void        removeReference(SbkObject* self, const char* key, PyObject* referredObject);
+/// Same as removeReference(SbkObject*, const char*, PyObject*) using a slot given by referenceSlot.
+LIBSHIBOKEN_API void        removeReference(SbkObject* self, int slot, PyObject* referredObject);
 
 } // namespace Object
 
@@ -24,24 +24,39 @@
 #define BASEWRAPPER_P_H
 
 #include "sbkpython.h"
+#include "bindingmanager.h"
 #include <list>
 #include <map>
+#include <vector>
 
 struct SbkObject;
 struct SbkObjectType;
 
 namespace Shiboken
 {
+/// A reference to a Python object kept by a wrapper, see Object::keepReference.
+struct KeptReference
+{
+    KeptReference(int slot, PyObject* object) : slot(slot), object(object) {}
+    /// Identifies the method and argument from where the object came, see Object::referenceSlot.
+    int slot;
+    PyObject* object;
+};
+
 /**
-    * This mapping associates a method and argument of an wrapper object with the wrapper of
+    * This list associates a method and argument of an wrapper object with the wrapper of
     * said argument when it needs the binding to help manage its reference counting.
+    * Wrappers keep just a few references, so they are stored in a flat vector.
     */
-typedef std::map<std::string, std::list<PyObject*> > RefCountMap;
+typedef std::vector<KeptReference> RefCountList;
 
 
 /// Linked list of SbkBaseWrapper pointers
 typedef std::set<SbkObject*> ChildrenList;
 
+/// Maps the address of a field to the wrapper created for it, see Object::fieldView.
+typedef std::map<const void*, SbkObject*> FieldViewMap;
+
 /// Struct used to store information about object parent and children.
 struct ParentInfo
 {
@@ -51,6 +66,8 @@ struct ParentInfo
     SbkObject* parent;
     /// List of object children.
     ChildrenList children;
+    /// Children that are views of fields living inside the object memory, indexed by address.
+    FieldViewMap fieldViews;
     /// has internal ref
     bool hasWrapperRef;
 };
@@ -79,7 +96,7 @@ struct SbkObjectPrivate
     /// Information about the object parents and children, can be null.
     Shiboken::ParentInfo* parentInfo;
     /// Manage reference counting of objects that are referred but not owned.
-    Shiboken::RefCountMap* referredObjects;
+    Shiboken::RefCountList* referredObjects;
 };
 
 /// The type behaviour was not defined yet
@@ -111,10 +128,18 @@ struct SbkObjectTypePrivate
     int type_behaviour:2;
     /// C++ name
     char* original_name;
+    /// True if the C++ destructor can run in any thread, without the GIL.
+    int threadsafe_dtor:1;
     /// Type user data
     void *user_data;
     DeleteUserDataFunc d_func;
     void (*subtype_init)(SbkObjectType*, PyObject*, PyObject*);
+    /// Number of live instances of this exact type, see ObjectType::instanceHistogram.
+    Py_ssize_t live_instances;
+    /// Bytes allocated by SbkObjectTpNew for the live instances of this exact type.
+    Py_ssize_t live_bytes;
+    /// True if the type is listed by ObjectType::instanceHistogram, i.e. an instance of it was ever created.
+    int is_counted:1;
 };
 
 
@@ -180,7 +205,7 @@ public:
     virtual void visit(SbkObjectType* node)
     {
         m_index++;
-        if (PyType_IsSubtype(reinterpret_cast<PyTypeObject*>(node), m_desiredType))
+        if (BindingManager::instance().isSubType(node, reinterpret_cast<SbkObjectType*>(m_desiredType)))
             finish();
     }
     int index() const { return m_index; }
@@ -190,6 +215,35 @@ private:
     PyTypeObject* m_desiredType;
 };
 
+/**
+ *  Registers \p function with the atexit module, it's called before the interpreter finalization,
+ *  with the GIL held. Used to stop the threads started by libshiboken.
+ *  \returns false if it couldn't be registered.
+ */
+bool callAtExit(void (*function)());
+
+/**
+ *  While an instance of this class is alive the C++ objects owned by wrappers dying in the current
+ *  thread are not destroyed immediately, but queued and destroyed together, releasing the GIL only
+ *  once, when the outermost instance goes out of scope. Must be used with the GIL held.
+ */
+class DestructionBatch
+{
+public:
+    DestructionBatch();
+    ~DestructionBatch();
+    /**
+     *  Destroys the C++ object \p cptr using the destructor of \p type. The object is sent to the
+     *  destructor thread if \p type has a thread safe destructor and \p hasCppWrapper is false,
+     *  queued if there is an active batch in the current thread, or else destroyed immediately.
+     */
+    static void destroy(SbkObjectType* type, void* cptr, bool hasCppWrapper);
+private:
+    bool m_active;
+    DestructionBatch(const DestructionBatch&);
+    DestructionBatch& operator=(const DestructionBatch&);
+};
+
 class DtorCallerVisitor : public HierarchyVisitor
 {
 public:
@@ -26,10 +26,17 @@
 #include "google/dense_hash_map"
 #include "sbkdbg.h"
 #include "gilstate.h"
+#include "sbktrace.h"
 #include "sbkstring.h"
 
 #include <cstddef>
+#include <cstdio>
 #include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 
 namespace Shiboken
@@ -42,17 +49,20 @@ class Graph
 public:
     typedef std::list<SbkObjectType*> NodeList;
     typedef google::dense_hash_map<SbkObjectType*, NodeList> Edges;
+    typedef google::dense_hash_map<SbkObjectType*, std::vector<int> > Positions;
 
     Edges m_edges;
 
-    Graph()
+    Graph() : m_flattened(true)
     {
         m_edges.set_empty_key(0);
+        m_positions.set_empty_key(0);
     }
 
     void addEdge(SbkObjectType* from, SbkObjectType* to)
     {
         m_edges[from].push_back(to);
+        m_flattened = false;
     }
 
 #ifndef NDEBUG
@@ -74,18 +84,54 @@ public:
     }
 #endif
 
-    SbkObjectType* identifyType(void** cptr, SbkObjectType* type, SbkObjectType* baseType) const
+    SbkObjectType* identifyType(void** cptr, SbkObjectType* type, SbkObjectType* baseType)
     {
-        Edges::const_iterator edgesIt = m_edges.find(type);
-        if (edgesIt != m_edges.end()) {
-            const NodeList& adjNodes = m_edges.find(type)->second;
-            NodeList::const_iterator i = adjNodes.begin();
-            for (; i != adjNodes.end(); ++i) {
-                SbkObjectType* newType = identifyType(cptr, *i, baseType);
-                if (newType)
-                    return newType;
-            }
+        flatten();
+        Positions::const_iterator it = m_positions.find(type);
+        if (it == m_positions.end())
+            return discoverType(cptr, type, baseType);
+
+        // The subtree of a type is walked backwards to test the most derived types first,
+        // in the same order a recursive walk on the edges would do.
+        int first = it->second.front();
+        for (int i = m_subtreeEnd[first] - 1; i >= first; --i) {
+            SbkObjectType* typeFound = discoverType(cptr, m_nodes[i], baseType);
+            if (typeFound)
+                return typeFound;
+        }
+        return 0;
+    }
+
+    /// Returns 1 if \p type inherits from \p baseType, 0 if it doesn't, or -1 if any of them is not in the graph.
+    int isSubType(SbkObjectType* type, SbkObjectType* baseType)
+    {
+        flatten();
+        Positions::const_iterator typeIt = m_positions.find(type);
+        Positions::const_iterator baseIt = m_positions.find(baseType);
+        if (typeIt == m_positions.end() || baseIt == m_positions.end())
+            return -1;
+        int first = baseIt->second.front();
+        const std::vector<int>& positions = typeIt->second;
+        for (std::vector<int>::const_iterator i = positions.begin(); i != positions.end(); ++i) {
+            if (*i > first && *i < m_subtreeEnd[first])
+                return 1;
         }
+        return 0;
+    }
+
+private:
+    /**
+     *  The hierarchy flattened in preorder, with the children of a node in reverse order.
+     *  The subtree of the node at position i is [i, m_subtreeEnd[i]). A type with more than one
+     *  base appears once under each base, all its positions are kept in m_positions.
+     */
+    std::vector<SbkObjectType*> m_nodes;
+    std::vector<int> m_subtreeEnd;
+    Positions m_positions;
+    bool m_flattened;
+
+    static SbkObjectType* discoverType(void** cptr, SbkObjectType* type, SbkObjectType* baseType)
+    {
         void* typeFound = ((type->d && type->d->type_discovery) ? type->d->type_discovery(*cptr, baseType) : 0);
         if (typeFound) {
             // This "typeFound != type" is needed for backwards compatibility with old modules using a newer version of
@@ -98,6 +144,42 @@ public:
             return 0;
         }
     }
+
+    // Rebuilt on the first query after new modules added their classes.
+    void flatten()
+    {
+        if (m_flattened)
+            return;
+        m_nodes.clear();
+        m_subtreeEnd.clear();
+        m_positions.clear();
+
+        std::set<SbkObjectType*> children;
+        Edges::const_iterator i = m_edges.begin();
+        for (; i != m_edges.end(); ++i)
+            children.insert(i->second.begin(), i->second.end());
+        for (i = m_edges.begin(); i != m_edges.end(); ++i) {
+            if (!children.count(i->first))
+                flattenSubtree(i->first);
+        }
+        m_flattened = true;
+    }
+
+    void flattenSubtree(SbkObjectType* node)
+    {
+        int position = m_nodes.size();
+        m_nodes.push_back(node);
+        m_subtreeEnd.push_back(0);
+        m_positions[node].push_back(position);
+        Edges::const_iterator edgesIt = m_edges.find(node);
+        if (edgesIt != m_edges.end()) {
+            const NodeList& adjNodes = edgesIt->second;
+            NodeList::const_reverse_iterator i = adjNodes.rbegin();
+            for (; i != adjNodes.rend(); ++i)
+                flattenSubtree(*i);
+        }
+        m_subtreeEnd[position] = m_nodes.size();
+    }
 };
 
 
@@ -145,6 +227,43 @@ void BindingManager::BindingManagerPrivate::assignWrapper(SbkObject* wrapper, co
         wrapperMapper.insert(std::make_pair(cptr, wrapper));
 }
 
+// Lock-free queue of the C++ objects destroyed by threads not holding the GIL. Any thread pushes
+// to its head, the thread holding the GIL takes the whole list at once, so a node is never
+// popped while a producer looks at it, and reused node addresses can't confuse the producers.
+struct PendingInvalidation
+{
+    void* cptr;
+    PendingInvalidation* next;
+};
+
+static PendingInvalidation* volatile pendingInvalidations = 0;
+static bool deferredInvalidationEnabled = false;
+static bool processingInvalidations = false;
+
+static inline PendingInvalidation* compareAndSwap(PendingInvalidation* volatile* head, PendingInvalidation* expected, PendingInvalidation* desired)
+{
+#ifdef _WIN32
+    return reinterpret_cast<PendingInvalidation*>(InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(head), desired, expected));
+#else
+    return __sync_val_compare_and_swap(head, expected, desired);
+#endif
+}
+
+static inline PendingInvalidation* takeAll(PendingInvalidation* volatile* head)
+{
+#ifdef _WIN32
+    return reinterpret_cast<PendingInvalidation*>(InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(head), 0));
+#else
+    return __sync_lock_test_and_set(head, static_cast<PendingInvalidation*>(0));
+#endif
+}
+
+static int processPendingInvalidationsCall(void*)
+{
+    BindingManager::instance().processPendingInvalidations();
+    return 0;
+}
+
 BindingManager::BindingManager()
 {
     m_d = new BindingManager::BindingManagerPrivate;
@@ -174,6 +293,8 @@ BindingManager& BindingManager::instance() {
 
 bool BindingManager::hasWrapper(const void* cptr)
 {
+    if (pendingInvalidations)
+        processPendingInvalidations();
     return m_d->wrapperMapper.find(cptr) != m_d->wrapperMapper.end();
 }
 
@@ -185,6 +306,9 @@ void BindingManager::registerWrapper(SbkObject* pyObj, void* cptr)
     if (!d)
         return;
 
+    // An object destroyed in another thread may have left a wrapper at the same address.
+    if (pendingInvalidations)
+        processPendingInvalidations();
     if (d->mi_init && !d->mi_offsets)
         d->mi_offsets = d->mi_init(cptr);
     m_d->assignWrapper(pyObj, cptr);
@@ -220,14 +344,99 @@ void BindingManager::releaseWrapper(SbkObject* sbkObj)
     sbkObj->d->validCppObject = false;
 }
 
+std::size_t BindingManager::wrapperMapUsage(SbkObject* wrapper)
+{
+    const WrapperMap& wrapperMap = m_d->wrapperMapper;
+    SbkObjectTypePrivate* d = reinterpret_cast<SbkObjectType*>(Py_TYPE(wrapper))->d;
+    int numBases = ((d && d->is_multicpp) ? getNumberOfCppBaseClasses(Py_TYPE(wrapper)) : 1);
+
+    std::size_t entries = 0;
+    for (int i = 0; i < numBases; ++i) {
+        char* cptr = reinterpret_cast<char*>(wrapper->d->cptr[i]);
+        if (!cptr)
+            continue;
+        std::vector<const void*> addresses(1, cptr);
+        if (d && d->mi_offsets) {
+            for (int* offset = d->mi_offsets; *offset != -1; ++offset) {
+                if (*offset > 0)
+                    addresses.push_back(cptr + *offset);
+            }
+        }
+        for (std::size_t j = 0; j < addresses.size(); ++j) {
+            WrapperMap::const_iterator it = wrapperMap.find(addresses[j]);
+            if (it != wrapperMap.end() && it->second == wrapper)
+                entries++;
+        }
+    }
+    if (!entries)
+        return 0;
+    return entries * sizeof(WrapperMap::value_type) * wrapperMap.bucket_count() / wrapperMap.size();
+}
+
 SbkObject* BindingManager::retrieveWrapper(const void* cptr)
 {
+    if (pendingInvalidations)
+        processPendingInvalidations();
     WrapperMap::iterator iter = m_d->wrapperMapper.find(cptr);
     if (iter == m_d->wrapperMapper.end())
         return 0;
     return iter->second;
 }
 
+void BindingManager::setDeferredInvalidation(bool enabled)
+{
+    deferredInvalidationEnabled = enabled;
+    if (!enabled)
+        processPendingInvalidations();
+}
+
+bool BindingManager::deferWrapperInvalidation(void* cptr)
+{
+    if (!deferredInvalidationEnabled || !Py_IsInitialized() || GilState::isHeld())
+        return false;
+
+    PendingInvalidation* node = new PendingInvalidation;
+    node->cptr = cptr;
+    PendingInvalidation* head = pendingInvalidations;
+    for (;;) {
+        node->next = head;
+        PendingInvalidation* previous = compareAndSwap(&pendingInvalidations, head, node);
+        if (previous == head)
+            break;
+        head = previous;
+    }
+    // Py_AddPendingCall may be called without the GIL, it fails only when its queue is full.
+    if (!head)
+        Py_AddPendingCall(processPendingInvalidationsCall, 0);
+    return true;
+}
+
+void BindingManager::processPendingInvalidations()
+{
+    if (!pendingInvalidations || processingInvalidations || !GilState::isHeld())
+        return;
+
+    processingInvalidations = true;
+    // The list is in reverse order of destruction.
+    PendingInvalidation* reversed = takeAll(&pendingInvalidations);
+    PendingInvalidation* pending = 0;
+    while (reversed) {
+        PendingInvalidation* next = reversed->next;
+        reversed->next = pending;
+        pending = reversed;
+        reversed = next;
+    }
+    while (pending) {
+        PendingInvalidation* next = pending->next;
+        WrapperMap::iterator iter = m_d->wrapperMapper.find(pending->cptr);
+        if (iter != m_d->wrapperMapper.end())
+            Object::destroy(iter->second, pending->cptr);
+        delete pending;
+        pending = next;
+    }
+    processingInvalidations = false;
+}
+
 PyObject* BindingManager::getOverride(const void* cptr, const char* methodName)
 {
     SbkObject* wrapper = retrieveWrapper(cptr);
@@ -240,6 +449,7 @@ PyObject* BindingManager::getOverride(const void* cptr, const char* methodName)
         PyObject* method = PyDict_GetItemString(wrapper->ob_dict, methodName);
         if (method) {
             Py_INCREF((PyObject*)method);
+            Trace::event(Trace::VirtualOverrideDispatched, wrapper, methodName);
             return method;
         }
     }
@@ -260,6 +470,7 @@ PyObject* BindingManager::getOverride(const void* cptr, const char* methodName)
                 defaultMethod = PyDict_GetItem(parent->tp_dict, pyMethodName);
                 if (defaultMethod && reinterpret_cast<PyMethodObject*>(method)->im_func != defaultMethod) {
                     Py_DECREF(pyMethodName);
+                    Trace::event(Trace::VirtualOverrideDispatched, wrapper, methodName);
                     return method;
                 }
             }
@@ -276,6 +487,16 @@ void BindingManager::addClassInheritance(SbkObjectType* parent, SbkObjectType* c
     m_d->classHierarchy.addEdge(parent, child);
 }
 
+bool BindingManager::isSubType(SbkObjectType* type, SbkObjectType* baseType)
+{
+    if (type == baseType)
+        return true;
+    int result = m_d->classHierarchy.isSubType(type, baseType);
+    if (result < 0)
+        return PyType_IsSubtype(reinterpret_cast<PyTypeObject*>(type), reinterpret_cast<PyTypeObject*>(baseType));
+    return result;
+}
+
 SbkObjectType* BindingManager::resolveType(void* cptr, SbkObjectType* type)
 {
     return resolveType(&cptr, type);
@@ -298,6 +519,54 @@ std::set<SbkObject*> BindingManager::getAllPyObjects()
     return pyObjects;
 }
 
+static void writeSnapshotNode(FILE* file, SbkObject* wrapper, int numBases)
+{
+    fprintf(file, "{\"node\":\"%p\",\"type\":\"%s\",\"cptr\":[", wrapper, Py_TYPE(wrapper)->tp_name);
+    for (int i = 0; i < numBases; ++i)
+        fprintf(file, "%s\"%p\"", i ? "," : "", wrapper->d->cptr[i]);
+    fprintf(file, "],\"owned_by_python\":%s,\"has_cpp_wrapper\":%s,\"valid\":%s,\"refcount\":%ld}\n",
+            wrapper->d->hasOwnership ? "true" : "false",
+            wrapper->d->containsCppWrapper ? "true" : "false",
+            wrapper->d->validCppObject ? "true" : "false",
+            static_cast<long>(Py_REFCNT(wrapper)));
+
+    ParentInfo* pInfo = wrapper->d->parentInfo;
+    if (pInfo) {
+        for (ChildrenList::const_iterator it = pInfo->children.begin(); it != pInfo->children.end(); ++it)
+            fprintf(file, "{\"edge\":\"child\",\"from\":\"%p\",\"to\":\"%p\"}\n", wrapper, *it);
+    }
+    RefCountList* referredObjects = wrapper->d->referredObjects;
+    if (referredObjects) {
+        for (RefCountList::const_iterator it = referredObjects->begin(); it != referredObjects->end(); ++it) {
+            fprintf(file, "{\"edge\":\"reference\",\"from\":\"%p\",\"to\":\"%p\",\"to_type\":\"%s\",\"slot\":%d}\n",
+                    wrapper, it->object, Py_TYPE(it->object)->tp_name, it->slot);
+        }
+    }
+}
+
+bool BindingManager::writeHeapSnapshot(const char* fileName)
+{
+    FILE* file = fopen(fileName, "w");
+    if (!file)
+        return false;
+
+    processPendingInvalidations();
+    const WrapperMap& wrapperMap = m_d->wrapperMapper;
+    for (WrapperMap::const_iterator it = wrapperMap.begin(); it != wrapperMap.end(); ++it) {
+        // A wrapper is registered for each of its C++ pointers and their multiple inheritance
+        // offsets, it's written only once, for the entry of its first C++ pointer.
+        SbkObject* wrapper = it->second;
+        SbkObjectTypePrivate* d = reinterpret_cast<SbkObjectType*>(Py_TYPE(wrapper))->d;
+        int numBases = ((d && d->is_multicpp) ? getNumberOfCppBaseClasses(Py_TYPE(wrapper)) : 1);
+        int first = 0;
+        while (first < numBases - 1 && !wrapper->d->cptr[first])
+            ++first;
+        if (it->first == wrapper->d->cptr[first])
+            writeSnapshotNode(file, wrapper, numBases);
+    }
+    return fclose(file) == 0;
+}
+
 void BindingManager::visitAllPyObjects(ObjectVisitor visitor, void* data)
 {
     WrapperMap copy = m_d->wrapperMapper;
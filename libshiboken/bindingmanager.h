@@ -46,9 +46,41 @@ public:
     void releaseWrapper(SbkObject* wrapper);
 
     SbkObject* retrieveWrapper(const void* cptr);
+
+    /**
+     * Returns the bytes taken by the entries of \p wrapper in the map of wrappers, one for each C++
+     * pointer and for each address of its bases with multiple inheritance. The empty buckets of
+     * the hash table are shared among all the entries.
+     */
+    std::size_t wrapperMapUsage(SbkObject* wrapper);
+
+    /**
+     * Enables the deferred invalidation of wrappers: the destructors of C++ wrappers running on
+     * threads that don't hold the GIL queue the C++ pointer instead of acquiring the GIL, and the
+     * wrapper is invalidated later by a thread holding the GIL. It's disabled by default.
+     */
+    void setDeferredInvalidation(bool enabled);
+    /**
+     * Called by the destructors of C++ wrappers. Queues \p cptr and returns true if the wrapper
+     * invalidation was deferred, otherwise the caller must destroy the wrapper itself.
+     * It doesn't need the GIL.
+     */
+    bool deferWrapperInvalidation(void* cptr);
+    /**
+     * Invalidates the wrappers whose C++ objects were destroyed in other threads. It's done before
+     * looking up, registering or validating wrappers, and by a Python pending call.
+     * Does nothing if the current thread doesn't hold the GIL.
+     */
+    void processPendingInvalidations();
     PyObject* getOverride(const void* cptr, const char* methodName);
 
     void addClassInheritance(SbkObjectType* parent, SbkObjectType* child);
+    /**
+     * Tells if \p type is \p baseType or inherits from it. For the wrapper types of the class hierarchy
+     * it takes two hash lookups and a range check for each place \p type has in the flattened hierarchy,
+     * one per inheritance path, instead of walking the bases. Other types fall back to PyType_IsSubtype.
+     */
+    bool isSubType(SbkObjectType* type, SbkObjectType* baseType);
     /**
      * \deprecated Use \fn resolveType(void**, SbkObjectType*), this version is broken when used with multiple inheritance
      *             because the \p cptr pointer of the discovered type may be different of the given \p cptr in case
@@ -75,6 +107,16 @@ public:
      */
     void visitAllPyObjects(ObjectVisitor visitor, void* data);
 
+    /**
+     * Writes the graph of the registered wrappers to \p fileName, one JSON object per line. A node is
+     * written for each wrapper, with its type, C++ pointers, ownership flags and reference count,
+     * followed by its edges to its children and to the objects it keeps references to.
+     * The file is written while walking the map of wrappers, nothing is copied, so it can be used
+     * with any number of wrappers. The GIL must be held.
+     * \returns false if the file couldn't be written.
+     */
+    bool writeHeapSnapshot(const char* fileName);
+
 private:
     ~BindingManager();
     // disable copy
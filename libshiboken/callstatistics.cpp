@@ -0,0 +1,135 @@
+/*
+ * This file is part of the Shiboken Python Bindings Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "callstatistics.h"
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+namespace Shiboken
+{
+namespace CallStatistics
+{
+
+// Registered functions, changed with the GIL held.
+static FunctionCallStatistics* registeredFunctions = 0;
+// Reference points used to convert ticks to seconds.
+static unsigned PY_LONG_LONG calibrationTicks = 0;
+static unsigned PY_LONG_LONG calibrationClock = 0;
+
+unsigned PY_LONG_LONG clockTicks()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return static_cast<unsigned PY_LONG_LONG>(double(counter.QuadPart) * 1e9 / double(frequency.QuadPart));
+#else
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return static_cast<unsigned PY_LONG_LONG>(tv.tv_sec) * 1000000000 + static_cast<unsigned PY_LONG_LONG>(tv.tv_usec) * 1000;
+#endif
+}
+
+void calibrate()
+{
+    if (!calibrationClock) {
+        calibrationClock = clockTicks();
+        calibrationTicks = ticks();
+    }
+}
+
+void registerFunction(FunctionCallStatistics* statistics)
+{
+    calibrate();
+    statistics->registered = true;
+    statistics->next = registeredFunctions;
+    registeredFunctions = statistics;
+}
+
+double secondsPerTick()
+{
+    unsigned PY_LONG_LONG clock;
+    do {
+        clock = clockTicks();
+    } while (clock - calibrationClock < 1000000);
+    unsigned PY_LONG_LONG elapsedTicks = ticks() - calibrationTicks;
+    return elapsedTicks ? double(clock - calibrationClock) * 1e-9 / double(elapsedTicks) : 1e-9;
+}
+
+static bool longerCall(const FunctionCallStatistics* a, const FunctionCallStatistics* b)
+{
+    return a->ticks > b->ticks;
+}
+
+PyObject* dump()
+{
+    std::vector<const FunctionCallStatistics*> functions;
+    for (const FunctionCallStatistics* statistics = registeredFunctions; statistics; statistics = statistics->next) {
+        if (statistics->calls)
+            functions.push_back(statistics);
+    }
+    std::sort(functions.begin(), functions.end(), longerCall);
+
+    PyObject* list = PyList_New(functions.size());
+    if (!list)
+        return 0;
+    double tickTime = functions.empty() ? 0 : secondsPerTick();
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        const FunctionCallStatistics* statistics = functions[i];
+        int overloadCount = statistics->overloadCalls ? statistics->overloadCount : 0;
+        PyObject* overloads = PyTuple_New(overloadCount);
+        for (int j = 0; overloads && j < overloadCount; ++j)
+            PyTuple_SET_ITEM(overloads, j, PyLong_FromUnsignedLong(statistics->overloadCalls[j]));
+        PyObject* item = overloads ? Py_BuildValue("{s:s,s:k,s:d,s:d,s:N}",
+                                                   "name", statistics->name,
+                                                   "calls", statistics->calls,
+                                                   "time", double(statistics->ticks) * tickTime,
+                                                   "gil_released_time", double(statistics->gilReleasedTicks) * tickTime,
+                                                   "overloads", overloads) : 0;
+        if (!item) {
+            Py_DECREF(list);
+            return 0;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+void reset()
+{
+    for (FunctionCallStatistics* statistics = registeredFunctions; statistics; statistics = statistics->next) {
+        statistics->calls = 0;
+        statistics->ticks = 0;
+        statistics->gilReleasedTicks = 0;
+        for (int i = 0; statistics->overloadCalls && i < statistics->overloadCount; ++i)
+            statistics->overloadCalls[i] = 0;
+    }
+}
+
+} // namespace CallStatistics
+} // namespace Shiboken
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the Shiboken Python Bindings Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CALLSTATISTICS_H
+#define CALLSTATISTICS_H
+
+#include "sbkpython.h"
+#include "shibokenmacros.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
+namespace Shiboken
+{
+
+/**
+ *  Counters of a bound function, defined as a static variable by the code generated with the
+ *  "call-statistics" option. They are only updated by threads holding the GIL, so no locking
+ *  or atomic operation is needed.
+ */
+struct FunctionCallStatistics
+{
+    const char* name;
+    /// Number of overloads, and the calls to each one of them, or NULL if there is only one.
+    int overloadCount;
+    unsigned long* overloadCalls;
+    unsigned long calls;
+    unsigned PY_LONG_LONG ticks;
+    unsigned PY_LONG_LONG gilReleasedTicks;
+    bool registered;
+    FunctionCallStatistics* next;
+};
+
+namespace CallStatistics
+{
+
+/// Used by ticks() where the CPU time stamp counter isn't available.
+LIBSHIBOKEN_API unsigned PY_LONG_LONG clockTicks();
+
+/**
+ *  Returns a counter increasing at a constant rate, the CPU time stamp counter where available.
+ */
+inline unsigned PY_LONG_LONG ticks()
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    return __rdtsc();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    unsigned int low, high;
+    __asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+    return (static_cast<unsigned PY_LONG_LONG>(high) << 32) | low;
+#else
+    return clockTicks();
+#endif
+}
+
+/**
+ *  Takes the reference points used by secondsPerTick(), if not taken yet. It's done when the first
+ *  function is registered.
+ */
+LIBSHIBOKEN_API void calibrate();
+
+/**
+ *  Returns the duration of a tick, measured against the clock since calibrate() was called.
+ *  It waits until at least a millisecond passed since then.
+ */
+LIBSHIBOKEN_API double secondsPerTick();
+
+/// Adds \p statistics to the ones returned by dump(), it's done on the first call to the function.
+LIBSHIBOKEN_API void registerFunction(FunctionCallStatistics* statistics);
+
+/**
+ *  Returns a list with a dictionary for each function called since the last reset(), with the
+ *  keys "name", "calls", "time", "gil_released_time" and "overloads", a tuple with the calls
+ *  to each overload. Times are in seconds. The list is sorted by time, from the longest.
+ */
+LIBSHIBOKEN_API PyObject* dump();
+
+/// Sets all the counters to zero.
+LIBSHIBOKEN_API void reset();
+
+} // namespace CallStatistics
+
+/**
+ *  Counts a call to the function owning \p statistics and the time spent until stop() is called
+ *  or until its destruction. The GIL must be held during both.
+ */
+class CallTimer
+{
+public:
+    inline explicit CallTimer(FunctionCallStatistics& statistics) : m_statistics(statistics), m_running(true)
+    {
+        if (!m_statistics.registered)
+            CallStatistics::registerFunction(&m_statistics);
+        m_statistics.calls++;
+        m_start = CallStatistics::ticks();
+    }
+    inline ~CallTimer()
+    {
+        stop();
+    }
+    /// Adds the time spent so far, for calls that release the GIL before returning.
+    inline void stop()
+    {
+        if (!m_running)
+            return;
+        m_statistics.ticks += CallStatistics::ticks() - m_start;
+        m_running = false;
+    }
+    inline void overloadChosen(int overloadId)
+    {
+        if (m_statistics.overloadCalls && overloadId >= 0 && overloadId < m_statistics.overloadCount)
+            m_statistics.overloadCalls[overloadId]++;
+    }
+    /// Called before releasing the GIL.
+    inline void releasingGil()
+    {
+        m_gilReleaseStart = CallStatistics::ticks();
+    }
+    /// Called after taking back the GIL.
+    inline void gilAcquired()
+    {
+        m_statistics.gilReleasedTicks += CallStatistics::ticks() - m_gilReleaseStart;
+    }
+private:
+    FunctionCallStatistics& m_statistics;
+    unsigned PY_LONG_LONG m_start;
+    unsigned PY_LONG_LONG m_gilReleaseStart;
+    bool m_running;
+
+    CallTimer(const CallTimer&);
+    CallTimer& operator=(const CallTimer&);
+};
+
+} // namespace Shiboken
+
+#endif // CALLSTATISTICS_H
@@ -27,6 +27,7 @@
 #include <limits>
 #include <memory>
 #include <typeinfo>
+#include <utility>
 
 #include "sbkstring.h"
 #include "sbkenum.h"
@@ -176,6 +177,13 @@ struct ValueTypeConverter
 //         SbkBaseWrapper_setContainsCppWrapper(obj, SbkTypeInfo<T>::isCppWrapper);
         return obj;
     }
+#ifdef SBK_HAS_RVALUE_REFERENCES
+    /// Moves a temporary into the storage of the new wrapper instead of copying it.
+    static inline PyObject* toPython(T&& cppobj)
+    {
+        return createWrapper<T>(new T(std::move(cppobj)), true, true);
+    }
+#endif
     // Classes with implicit conversions are expected to reimplement 'toCpp' to build T from
     // its various implicit constructors. Even classes without implicit conversions could
     // get some of those via other modules defining conversion operator for them, thus
@@ -188,7 +196,7 @@ struct ValueTypeConverter
             if (ObjectType::hasExternalCppConversions(shiboType) && isConvertible(pyobj)) {
                 T* cptr = reinterpret_cast<T*>(ObjectType::callExternalCppConversion(shiboType, pyobj));
                 std::auto_ptr<T> cptr_auto_ptr(cptr);
-                return *cptr;
+                return SBK_MOVE(*cptr);
             }
             assert(false);
         }
@@ -21,16 +21,57 @@
  */
 
 #include "gilstate.h"
+#include "sbktrace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
 
 namespace Shiboken
 {
 
-GilState::GilState()
+// Only changed with the GIL held.
+static unsigned long gilAcquiredCount = 0;
+static unsigned long gilAlreadyHeldCount = 0;
+
+// The thread state of the current thread is kept by Python in a thread local storage,
+// the thread holds the GIL if it is also the state running the interpreter.
+static inline bool currentThreadHoldsGil()
+{
+    PyThreadState* threadState = PyGILState_GetThisThreadState();
+    if (!threadState)
+        return false;
+#if PY_VERSION_HEX >= 0x030D0000
+    return threadState == PyThreadState_GetUnchecked();
+#elif PY_VERSION_HEX >= 0x03050200
+    return threadState == _PyThreadState_UncheckedGet();
+#elif PY_VERSION_HEX >= 0x03030000
+    return threadState == reinterpret_cast<PyThreadState*>(_Py_atomic_load_relaxed(&_PyThreadState_Current));
+#else
+    return threadState == _PyThreadState_Current;
+#endif
+}
+
+GilState::GilState() : m_locked(false)
 {
-    if(Py_IsInitialized()) {
-        m_gstate = PyGILState_Ensure();
-        m_locked = true;
+    if (!Py_IsInitialized())
+        return;
+    if (currentThreadHoldsGil()) {
+        gilAlreadyHeldCount++;
+        return;
     }
+    m_gstate = PyGILState_Ensure();
+    m_locked = true;
+    gilAcquiredCount++;
+    Trace::event(Trace::GilAcquired);
 }
 
 GilState::~GilState()
@@ -41,10 +82,113 @@ GilState::~GilState()
 void GilState::release()
 {
     if(m_locked && Py_IsInitialized()) {
+        Trace::event(Trace::GilReleased);
         PyGILState_Release(m_gstate);
         m_locked = false;
     }
 }
-} // namespace Shiboken
 
+unsigned long GilState::acquiredCount()
+{
+    return gilAcquiredCount;
+}
+
+unsigned long GilState::alreadyHeldCount()
+{
+    return gilAlreadyHeldCount;
+}
+
+void GilState::resetCounters()
+{
+    gilAcquiredCount = 0;
+    gilAlreadyHeldCount = 0;
+}
+
+bool GilState::isHeld()
+{
+    return currentThreadHoldsGil();
+}
+
+// Wall clock time in microseconds.
+static double currentTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return double(counter.QuadPart) * 1e6 / double(frequency.QuadPart);
+#else
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return double(tv.tv_sec) * 1e6 + double(tv.tv_usec);
+#endif
+}
+
+struct GilHoldTime
+{
+    GilHoldTime() : calls(0), time(0) {}
+    unsigned long calls;
+    double time;
+};
+
+// Only changed with the GIL held, which is what is being measured.
+typedef std::map<std::string, GilHoldTime> GilHoldTimes;
+static GilHoldTimes* gilHoldTimes = 0;
+static int gilHoldReportEnabled = -1;
+
+static bool longerGilHoldTime(const GilHoldTimes::value_type* a, const GilHoldTimes::value_type* b)
+{
+    return a->second.time > b->second.time;
+}
+
+static void writeGilHoldReport()
+{
+    std::vector<const GilHoldTimes::value_type*> times;
+    for (GilHoldTimes::const_iterator it = gilHoldTimes->begin(); it != gilHoldTimes->end(); ++it)
+        times.push_back(&*it);
+    std::sort(times.begin(), times.end(), longerGilHoldTime);
+
+    fprintf(stderr, "Time spent in C++ calls holding the GIL: ms, calls, function\n");
+    for (std::size_t i = 0; i < times.size(); ++i)
+        fprintf(stderr, "%12.3f %10lu %s\n", times[i]->second.time / 1000.0, times[i]->second.calls, times[i]->first.c_str());
+    delete gilHoldTimes;
+    gilHoldTimes = 0;
+}
+
+static bool gilHoldDiagnosticEnabled()
+{
+    if (gilHoldReportEnabled < 0) {
+        gilHoldReportEnabled = getenv("SHIBOKEN_GIL_HOLD_REPORT") ? 1 : 0;
+        if (gilHoldReportEnabled) {
+            gilHoldTimes = new GilHoldTimes;
+            Py_AtExit(writeGilHoldReport);
+        }
+    }
+    return gilHoldReportEnabled && gilHoldTimes;
+}
+
+GilHoldTimer::GilHoldTimer(const char* function) : m_function(0), m_start(0)
+{
+    if (gilHoldDiagnosticEnabled()) {
+        m_function = function;
+        m_start = currentTime();
+    }
+}
+
+GilHoldTimer::~GilHoldTimer()
+{
+    stop();
+}
+
+void GilHoldTimer::stop()
+{
+    if (!m_function || !gilHoldTimes)
+        return;
+    GilHoldTime& holdTime = (*gilHoldTimes)[m_function];
+    holdTime.calls++;
+    holdTime.time += currentTime() - m_start;
+    m_function = 0;
+}
+
+} // namespace Shiboken
 
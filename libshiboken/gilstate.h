@@ -29,17 +29,49 @@
 namespace Shiboken
 {
 
+/**
+ *  Holds the GIL while alive. If the current thread already holds the GIL, as when Python calls
+ *  C++ code that calls back into Python, nothing is acquired nor released.
+ */
 class LIBSHIBOKEN_API GilState
 {
 public:
     GilState();
     ~GilState();
     void release();
+
+    /// Number of GilState instances that had to acquire the GIL.
+    static unsigned long acquiredCount();
+    /// Number of GilState instances that found the GIL already held by the current thread.
+    static unsigned long alreadyHeldCount();
+    static void resetCounters();
+    /// Returns true if the current thread holds the GIL.
+    static bool isHeld();
 private:
     PyGILState_STATE m_gstate;
     bool m_locked;
 };
 
+/**
+ *  Measures the time spent in a C++ call made while holding the GIL, for the diagnostic
+ *  enabled by the SHIBOKEN_GIL_HOLD_REPORT environment variable. The time spent in each
+ *  function is reported to stderr, from the longest, when the interpreter exits.
+ *  Bindings use it when generated with the "gil-hold-diagnostics" option.
+ */
+class LIBSHIBOKEN_API GilHoldTimer
+{
+public:
+    explicit GilHoldTimer(const char* function);
+    ~GilHoldTimer();
+    void stop();
+private:
+    const char* m_function;
+    double m_start;
+
+    GilHoldTimer(const GilHoldTimer&);
+    GilHoldTimer& operator=(const GilHoldTimer&);
+};
+
 } // namespace Shiboken
 
 #endif // GILSTATE_H
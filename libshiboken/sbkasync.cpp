@@ -0,0 +1,421 @@
+/*
+ * This file is part of the Shiboken Python Bindings Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sbkasync.h"
+#include "basewrapper.h"
+#include "basewrapper_p.h"
+#include "autodecref.h"
+#include "gilstate.h"
+#include "threadstatesaver.h"
+#include <pythread.h>
+#include <list>
+#include <vector>
+
+extern "C"
+{
+
+struct SbkFuture
+{
+    PyObject_HEAD
+    // The pending call, cleared once it's made.
+    PyObject* callable;
+    PyObject* args;
+    PyObject* kwds;
+    // Outcome of the call, set by the worker thread with the GIL held.
+    PyObject* result;
+    PyObject* errorType;
+    PyObject* errorValue;
+    PyObject* errorTraceback;
+    int finished;
+    // Locked until the call finishes.
+    PyThread_type_lock finishedLock;
+    // Event loop and asyncio future of the coroutines awaiting the result.
+    PyObject* loop;
+    PyObject* asyncioFuture;
+};
+
+static void SbkFuture_dealloc(PyObject* self)
+{
+    SbkFuture* future = reinterpret_cast<SbkFuture*>(self);
+    Py_XDECREF(future->callable);
+    Py_XDECREF(future->args);
+    Py_XDECREF(future->kwds);
+    Py_XDECREF(future->result);
+    Py_XDECREF(future->errorType);
+    Py_XDECREF(future->errorValue);
+    Py_XDECREF(future->errorTraceback);
+    Py_XDECREF(future->loop);
+    Py_XDECREF(future->asyncioFuture);
+    if (future->finishedLock)
+        PyThread_free_lock(future->finishedLock);
+    PyObject_Del(self);
+}
+
+// Called on the event loop thread to pass the outcome of the call to the awaiting coroutines.
+static PyObject* SbkFuture_completeAsyncioFuture(PyObject* self, PyObject*)
+{
+    SbkFuture* future = reinterpret_cast<SbkFuture*>(self);
+    Shiboken::AutoDecRef done(PyObject_CallMethod(future->asyncioFuture, const_cast<char*>("done"), 0));
+    if (done.isNull())
+        return 0;
+    // The awaiting task may have been cancelled.
+    if (PyObject_IsTrue(done))
+        Py_RETURN_NONE;
+
+    Shiboken::AutoDecRef ret(0);
+    if (future->result)
+        ret = PyObject_CallMethod(future->asyncioFuture, const_cast<char*>("set_result"), const_cast<char*>("O"), future->result);
+    else
+        ret = PyObject_CallMethod(future->asyncioFuture, const_cast<char*>("set_exception"), const_cast<char*>("O"), future->errorValue);
+    if (ret.isNull())
+        return 0;
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef completeAsyncioFutureDef = {
+    "_completeAsyncioFuture", (PyCFunction)SbkFuture_completeAsyncioFuture, METH_NOARGS
+};
+
+static PyObject* SbkFuture_done(PyObject* self, PyObject*)
+{
+    return PyBool_FromLong(reinterpret_cast<SbkFuture*>(self)->finished);
+}
+
+static PyObject* SbkFuture_result(PyObject* self, PyObject*)
+{
+    SbkFuture* future = reinterpret_cast<SbkFuture*>(self);
+    if (!future->finished) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(future->finishedLock, WAIT_LOCK);
+        PyThread_release_lock(future->finishedLock);
+        Py_END_ALLOW_THREADS
+    }
+
+    if (future->result) {
+        Py_INCREF(future->result);
+        return future->result;
+    }
+    Py_XINCREF(future->errorType);
+    Py_XINCREF(future->errorValue);
+    Py_XINCREF(future->errorTraceback);
+    PyErr_Restore(future->errorType, future->errorValue, future->errorTraceback);
+    return 0;
+}
+
+#if PY_VERSION_HEX >= 0x03050000
+static PyObject* SbkFuture_await(PyObject* self)
+{
+    SbkFuture* future = reinterpret_cast<SbkFuture*>(self);
+    if (!future->asyncioFuture) {
+        Shiboken::AutoDecRef asyncio(PyImport_ImportModule("asyncio"));
+        if (asyncio.isNull())
+            return 0;
+        PyObject* loop = PyObject_CallMethod(asyncio, const_cast<char*>("get_event_loop"), 0);
+        if (!loop)
+            return 0;
+        PyObject* asyncioFuture = PyObject_CallMethod(loop, const_cast<char*>("create_future"), 0);
+        if (!asyncioFuture) {
+            Py_DECREF(loop);
+            return 0;
+        }
+        // The worker thread looks at these with the GIL held, after setting "finished".
+        future->loop = loop;
+        future->asyncioFuture = asyncioFuture;
+        if (future->finished) {
+            Shiboken::AutoDecRef ret(SbkFuture_completeAsyncioFuture(self, 0));
+            if (ret.isNull())
+                return 0;
+        }
+    }
+    return PyObject_CallMethod(future->asyncioFuture, const_cast<char*>("__await__"), 0);
+}
+
+static PyAsyncMethods SbkFuture_as_async = {
+    /*am_await*/ SbkFuture_await,
+    /*am_aiter*/ 0,
+    /*am_anext*/ 0
+};
+#endif
+
+static PyMethodDef SbkFuture_methods[] = {
+    {"done", (PyCFunction)SbkFuture_done, METH_NOARGS},
+    {"result", (PyCFunction)SbkFuture_result, METH_NOARGS},
+    {0} // Sentinel
+};
+
+PyTypeObject SbkFuture_Type = {
+    PyVarObject_HEAD_INIT(0, 0)
+    /*tp_name*/             "Shiboken.Future",
+    /*tp_basicsize*/        sizeof(SbkFuture),
+    /*tp_itemsize*/         0,
+    /*tp_dealloc*/          SbkFuture_dealloc,
+    /*tp_print*/            0,
+    /*tp_getattr*/          0,
+    /*tp_setattr*/          0,
+#if PY_VERSION_HEX >= 0x03050000
+    /*tp_as_async*/         &SbkFuture_as_async,
+#else
+    /*tp_compare*/          0,
+#endif
+    /*tp_repr*/             0,
+    /*tp_as_number*/        0,
+    /*tp_as_sequence*/      0,
+    /*tp_as_mapping*/       0,
+    /*tp_hash*/             0,
+    /*tp_call*/             0,
+    /*tp_str*/              0,
+    /*tp_getattro*/         0,
+    /*tp_setattro*/         0,
+    /*tp_as_buffer*/        0,
+    /*tp_flags*/            Py_TPFLAGS_DEFAULT,
+    /*tp_doc*/              0,
+    /*tp_traverse*/         0,
+    /*tp_clear*/            0,
+    /*tp_richcompare*/      0,
+    /*tp_weaklistoffset*/   0,
+    /*tp_iter*/             0,
+    /*tp_iternext*/         0,
+    /*tp_methods*/          SbkFuture_methods,
+    /*tp_members*/          0,
+    /*tp_getset*/           0,
+    /*tp_base*/             0,
+    /*tp_dict*/             0,
+    /*tp_descr_get*/        0,
+    /*tp_descr_set*/        0,
+    /*tp_dictoffset*/       0,
+    /*tp_init*/             0,
+    /*tp_alloc*/            0,
+    /*tp_new*/              0,
+    /*tp_free*/             0,
+    /*tp_is_gc*/            0,
+    /*tp_bases*/            0,
+    /*tp_mro*/              0,
+    /*tp_cache*/            0,
+    /*tp_subclasses*/       0,
+    /*tp_weaklist*/         0
+};
+
+} // extern "C"
+
+namespace Shiboken
+{
+namespace Async
+{
+
+// Calls waiting for a worker thread, each one holding a reference to its future.
+static std::list<SbkFuture*> pendingCalls;
+// Wake-up locks of the worker threads waiting for calls, a worker is woken by releasing its lock.
+static std::vector<PyThread_type_lock> idleWorkers;
+static PyThread_type_lock poolMutex = 0;
+static int workerCount = 0;
+static int maxWorkerCount = 4;
+// Set when the interpreter exits, the workers finish the pending calls and then exit.
+static bool poolStopping = false;
+// Released by the last worker to exit after the pool was stopped.
+static PyThread_type_lock workersFinished = 0;
+
+static void finishCall(SbkFuture* future)
+{
+    GilState gil;
+    PyObject* result = PyObject_Call(future->callable, future->args, future->kwds);
+    if (result) {
+        future->result = result;
+    } else {
+        PyErr_Fetch(&future->errorType, &future->errorValue, &future->errorTraceback);
+        PyErr_NormalizeException(&future->errorType, &future->errorValue, &future->errorTraceback);
+#ifdef IS_PY3K
+        if (future->errorTraceback)
+            PyException_SetTraceback(future->errorValue, future->errorTraceback);
+#endif
+    }
+    Py_CLEAR(future->callable);
+    Py_CLEAR(future->args);
+    Py_CLEAR(future->kwds);
+    future->finished = 1;
+
+    if (future->loop) {
+        AutoDecRef callback(PyCFunction_New(&completeAsyncioFutureDef, reinterpret_cast<PyObject*>(future)));
+        AutoDecRef ret(PyObject_CallMethod(future->loop, const_cast<char*>("call_soon_threadsafe"), const_cast<char*>("O"), callback.object()));
+        // The event loop may have been closed meanwhile.
+        if (ret.isNull())
+            PyErr_WriteUnraisable(future->loop);
+    }
+    PyThread_release_lock(future->finishedLock);
+    Py_DECREF(future);
+}
+
+static void workerMain(void* data)
+{
+    PyThread_type_lock wakeUp = reinterpret_cast<PyThread_type_lock>(data);
+    for (;;) {
+        PyThread_acquire_lock(poolMutex, WAIT_LOCK);
+        if (pendingCalls.empty() && poolStopping) {
+            bool lastWorker = --workerCount == 0;
+            PyThread_release_lock(poolMutex);
+            PyThread_free_lock(wakeUp);
+            if (lastWorker)
+                PyThread_release_lock(workersFinished);
+            return;
+        }
+        if (pendingCalls.empty()) {
+            idleWorkers.push_back(wakeUp);
+            PyThread_release_lock(poolMutex);
+            PyThread_acquire_lock(wakeUp, WAIT_LOCK);
+            continue;
+        }
+        SbkFuture* future = pendingCalls.front();
+        pendingCalls.pop_front();
+        PyThread_release_lock(poolMutex);
+        finishCall(future);
+    }
+}
+
+// Starts a worker thread, called with poolMutex locked.
+static bool startWorker()
+{
+    PyThread_type_lock wakeUp = PyThread_allocate_lock();
+    if (!wakeUp)
+        return false;
+    PyThread_acquire_lock(wakeUp, WAIT_LOCK);
+    if (long(PyThread_start_new_thread(workerMain, wakeUp)) == -1) {
+        PyThread_free_lock(wakeUp);
+        return false;
+    }
+    ++workerCount;
+    return true;
+}
+
+// Called by the atexit module, before the interpreter finalization, with the GIL held.
+static void stopWorkers()
+{
+    PyThread_acquire_lock(poolMutex, WAIT_LOCK);
+    poolStopping = true;
+    for (std::size_t i = 0; i < idleWorkers.size(); ++i)
+        PyThread_release_lock(idleWorkers[i]);
+    idleWorkers.clear();
+    bool running = workerCount > 0;
+    PyThread_release_lock(poolMutex);
+
+    // The workers need the GIL to finish the pending calls.
+    if (running) {
+        ThreadStateSaver threadSaver;
+        threadSaver.save();
+        PyThread_acquire_lock(workersFinished, WAIT_LOCK);
+    }
+}
+
+static bool createPool()
+{
+    PyThread_type_lock mutex = PyThread_allocate_lock();
+    PyThread_type_lock finished = PyThread_allocate_lock();
+    if (!mutex || !finished || !callAtExit(stopWorkers)) {
+        if (mutex)
+            PyThread_free_lock(mutex);
+        if (finished)
+            PyThread_free_lock(finished);
+        return false;
+    }
+    PyThread_acquire_lock(finished, WAIT_LOCK);
+    poolMutex = mutex;
+    workersFinished = finished;
+    return true;
+}
+
+PyObject* call(PyObject* callable, PyObject* args, PyObject* kwds)
+{
+    if (!poolMutex && !createPool()) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not create the worker thread pool.");
+        return 0;
+    }
+    if (poolStopping) {
+        PyErr_SetString(PyExc_RuntimeError, "The worker thread pool was stopped.");
+        return 0;
+    }
+
+    SbkFuture* future = PyObject_New(SbkFuture, &SbkFuture_Type);
+    if (!future)
+        return 0;
+    Py_INCREF(callable);
+    Py_XINCREF(args);
+    Py_XINCREF(kwds);
+    future->callable = callable;
+    future->args = args ? args : PyTuple_New(0);
+    future->kwds = kwds;
+    future->result = 0;
+    future->errorType = 0;
+    future->errorValue = 0;
+    future->errorTraceback = 0;
+    future->finished = 0;
+    future->loop = 0;
+    future->asyncioFuture = 0;
+    future->finishedLock = PyThread_allocate_lock();
+    if (!future->finishedLock) {
+        Py_DECREF(future);
+        PyErr_SetString(PyExc_RuntimeError, "Could not create the lock of an asynchronous call.");
+        return 0;
+    }
+    PyThread_acquire_lock(future->finishedLock, WAIT_LOCK);
+
+    // The reference taken here is released by the worker thread.
+    Py_INCREF(future);
+    PyThread_acquire_lock(poolMutex, WAIT_LOCK);
+    pendingCalls.push_back(future);
+    bool started = true;
+    if (!idleWorkers.empty()) {
+        PyThread_release_lock(idleWorkers.back());
+        idleWorkers.pop_back();
+    } else if (workerCount < maxWorkerCount) {
+        started = startWorker() || workerCount > 0;
+    }
+    if (!started)
+        pendingCalls.pop_back();
+    PyThread_release_lock(poolMutex);
+
+    if (!started) {
+        Py_DECREF(future);
+        Py_DECREF(future);
+        PyErr_SetString(PyExc_RuntimeError, "Could not start a worker thread.");
+        return 0;
+    }
+    return reinterpret_cast<PyObject*>(future);
+}
+
+PyObject* callMethod(PyObject* self, const char* name, PyObject* args, PyObject* kwds)
+{
+    AutoDecRef method(PyObject_GetAttrString(self, const_cast<char*>(name)));
+    if (method.isNull())
+        return 0;
+    return call(method, args, kwds);
+}
+
+void setMaxThreads(int count)
+{
+    maxWorkerCount = count > 0 ? count : 1;
+}
+
+int maxThreads()
+{
+    return maxWorkerCount;
+}
+
+} // namespace Async
+} // namespace Shiboken
@@ -0,0 +1,69 @@
+/*
+ * This file is part of the Shiboken Python Bindings Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SBKASYNC_H
+#define SBKASYNC_H
+
+#include "sbkpython.h"
+#include "shibokenmacros.h"
+
+extern "C"
+{
+
+/**
+ *  Result of a call made on a libshiboken worker thread. It has the methods done() and
+ *  result(), the latter waiting for the call to finish, and can be awaited from an asyncio
+ *  event loop on Python 3.5 and newer.
+ */
+extern LIBSHIBOKEN_API PyTypeObject SbkFuture_Type;
+
+} // extern "C"
+
+namespace Shiboken
+{
+namespace Async
+{
+
+/**
+ *  Calls \p callable with \p args and \p kwds on a worker thread and returns a new
+ *  Shiboken.Future holding the result, or NULL with a Python error set in case of failure.
+ *  The worker thread holds the GIL while converting arguments and results, bound functions
+ *  releasing it around the C++ call let the interpreter run meanwhile.
+ */
+LIBSHIBOKEN_API PyObject* call(PyObject* callable, PyObject* args, PyObject* kwds);
+
+/**
+ *  Same as call(), for the method \p name of \p self. It's used by the "_async" variants
+ *  of the functions that release the GIL.
+ */
+LIBSHIBOKEN_API PyObject* callMethod(PyObject* self, const char* name, PyObject* args, PyObject* kwds);
+
+/**
+ *  Sets the maximum number of worker threads, started as needed by call(). The default is 4.
+ */
+LIBSHIBOKEN_API void setMaxThreads(int count);
+LIBSHIBOKEN_API int maxThreads();
+
+} // namespace Async
+} // namespace Shiboken
+
+#endif // SBKASYNC_H
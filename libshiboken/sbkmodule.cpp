@@ -23,6 +23,15 @@
 #include "sbkmodule.h"
 #include "basewrapper.h"
 #include "bindingmanager.h"
+#include "sbkstring.h"
+#include "callstatistics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
 
 // TODO: for performance reasons this should be a sparse_hash_map,
 // because there'll be very few modules as keys. The sparse_hash_map
@@ -35,6 +44,116 @@ typedef google::dense_hash_map<PyObject*, PyTypeObject**> ModuleTypesMap;
 /// All types produced in imported modules are mapped here.
 static ModuleTypesMap moduleTypes;
 
+/// A type registered to be initialized on its first use.
+struct LazyType
+{
+    std::string name;
+    Shiboken::Module::TypeInitFunction initFunction;
+    int ownerIndex;
+};
+
+/// The types of a module still waiting to be initialized.
+struct LazyTypeTable
+{
+    PyObject* module;
+    std::map<int, LazyType> pending;
+    std::map<std::string, int> names;
+};
+
+/// This maps the types arrays of modules with lazy types to their pending types.
+typedef std::map<PyTypeObject**, LazyTypeTable> LazyTypesMap;
+static LazyTypesMap lazyTypes;
+
+/// Position of a type in the types array of a module.
+typedef std::pair<PyTypeObject**, int> TypeSlot;
+
+/// Lazy subtypes of the base types not initialized yet, keyed by the position of the base.
+typedef std::map<TypeSlot, std::list<TypeSlot> > LazySubTypesBySlotMap;
+static LazySubTypesBySlotMap lazySubTypesBySlot;
+
+/// Lazy subtypes of the base types already initialized.
+typedef std::map<PyTypeObject*, std::list<TypeSlot> > LazySubTypesMap;
+static LazySubTypesMap lazySubTypes;
+
+static PyObject* SbkLazyModule_getattro(PyObject* module, PyObject* name);
+
+/// Modules with lazy types have this type, it initializes the types on attribute access.
+static PyTypeObject SbkLazyModule_Type = {
+    PyVarObject_HEAD_INIT(0, 0)
+    /*tp_name*/             "Shiboken.LazyModule",
+    /*tp_basicsize*/        0,
+    /*tp_itemsize*/         0,
+    /*tp_dealloc*/          0,
+    /*tp_print*/            0,
+    /*tp_getattr*/          0,
+    /*tp_setattr*/          0,
+    /*tp_compare*/          0,
+    /*tp_repr*/             0,
+    /*tp_as_number*/        0,
+    /*tp_as_sequence*/      0,
+    /*tp_as_mapping*/       0,
+    /*tp_hash*/             0,
+    /*tp_call*/             0,
+    /*tp_str*/              0,
+    /*tp_getattro*/         SbkLazyModule_getattro,
+    /*tp_setattro*/         0,
+    /*tp_as_buffer*/        0,
+    /*tp_flags*/            Py_TPFLAGS_DEFAULT,
+    /*tp_doc*/              0,
+    /*tp_traverse*/         0,
+    /*tp_clear*/            0,
+    /*tp_richcompare*/      0,
+    /*tp_weaklistoffset*/   0,
+    /*tp_iter*/             0,
+    /*tp_iternext*/         0,
+    /*tp_methods*/          0,
+    /*tp_members*/          0,
+    /*tp_getset*/           0,
+    /*tp_base*/             &PyModule_Type,
+    /*tp_dict*/             0,
+    /*tp_descr_get*/        0,
+    /*tp_descr_set*/        0,
+    /*tp_dictoffset*/       0,
+    /*tp_init*/             0,
+    /*tp_alloc*/            0,
+    /*tp_new*/              0,
+    /*tp_free*/             0,
+    /*tp_is_gc*/            0,
+    /*tp_bases*/            0,
+    /*tp_mro*/              0,
+    /*tp_cache*/            0,
+    /*tp_subclasses*/       0,
+    /*tp_weaklist*/         0
+};
+
+static PyObject* SbkLazyModule_getattro(PyObject* module, PyObject* name)
+{
+    PyTypeObject** types = Shiboken::Module::getLazyTypes(module);
+    LazyTypesMap::iterator iter = lazyTypes.find(types);
+    if (iter == lazyTypes.end() || iter->second.names.empty())
+        return PyModule_Type.tp_getattro(module, name);
+
+    // dir() and "from module import *" look at the module dictionary.
+    if (Shiboken::String::compare(name, "__dict__") == 0) {
+        Shiboken::Module::loadAllTypes(types);
+        return PyModule_Type.tp_getattro(module, name);
+    }
+
+    PyObject* attr = PyModule_Type.tp_getattro(module, name);
+    if (attr || !PyErr_ExceptionMatches(PyExc_AttributeError))
+        return attr;
+
+    const char* attrName = Shiboken::String::toCString(name);
+    std::map<std::string, int>::const_iterator nameIter = iter->second.names.find(attrName ? attrName : "");
+    if (nameIter == iter->second.names.end())
+        return 0;
+
+    PyErr_Clear();
+    if (!Shiboken::Module::initLazyType(types, nameIter->second))
+        return 0;
+    return PyModule_Type.tp_getattro(module, name);
+}
+
 namespace Shiboken
 {
 namespace Module
@@ -80,9 +199,265 @@ void registerTypes(PyObject* module, PyTypeObject** types)
 }
 
 PyTypeObject** getTypes(PyObject* module)
+{
+    PyTypeObject** types = getLazyTypes(module);
+    if (types)
+        loadAllTypes(types);
+    return types;
+}
+
+PyTypeObject** getLazyTypes(PyObject* module)
 {
     ModuleTypesMap::iterator iter = moduleTypes.find(module);
     return (iter == moduleTypes.end()) ? 0 : iter->second;
 }
 
+void registerLazyType(PyObject* module, PyTypeObject** types, const char* name, int index,
+                      TypeInitFunction initFunction, int enclosingIndex)
+{
+    LazyTypesMap::iterator iter = lazyTypes.find(types);
+    if (iter == lazyTypes.end()) {
+        if (PyType_Ready(&SbkLazyModule_Type) < 0)
+            return;
+        // Module attribute lookup must go through SbkLazyModule_getattro from now on.
+        module->ob_type = &SbkLazyModule_Type;
+        registerTypes(module, types);
+        iter = lazyTypes.insert(std::make_pair(types, LazyTypeTable())).first;
+        iter->second.module = module;
+    }
+
+    LazyType& lazyType = iter->second.pending[index];
+    lazyType.initFunction = initFunction;
+    lazyType.ownerIndex = enclosingIndex;
+    if (name) {
+        lazyType.name = name;
+        iter->second.names[name] = index;
+    }
+}
+
+void registerLazySubType(PyTypeObject** baseTypes, int baseIndex, PyTypeObject** types, int index)
+{
+    TypeSlot subType(types, index);
+    if (baseTypes[baseIndex])
+        lazySubTypes[baseTypes[baseIndex]].push_back(subType);
+    else
+        lazySubTypesBySlot[TypeSlot(baseTypes, baseIndex)].push_back(subType);
+}
+
+bool loadLazySubTypes(PyTypeObject* type)
+{
+    LazySubTypesMap::iterator iter = lazySubTypes.find(type);
+    if (iter == lazySubTypes.end())
+        return true;
+    std::list<TypeSlot> subTypes;
+    subTypes.swap(iter->second);
+    lazySubTypes.erase(iter);
+
+    // The subtypes of the subtypes are also needed to discover the most derived type.
+    for (std::list<TypeSlot>::const_iterator it = subTypes.begin(); it != subTypes.end(); ++it) {
+        PyTypeObject* subType = loadType(it->first, it->second);
+        if (!subType || !loadLazySubTypes(subType))
+            return false;
+    }
+    return true;
+}
+
+void registerLazyTypeIndex(PyTypeObject** types, int index, int ownerIndex)
+{
+    LazyTypesMap::iterator iter = lazyTypes.find(types);
+    if (iter == lazyTypes.end())
+        return;
+    LazyType& lazyType = iter->second.pending[index];
+    lazyType.initFunction = 0;
+    lazyType.ownerIndex = ownerIndex;
+}
+
+PyTypeObject* initLazyType(PyTypeObject** types, int index)
+{
+    if (types[index])
+        return types[index];
+
+    LazyTypesMap::iterator iter = lazyTypes.find(types);
+    if (iter == lazyTypes.end())
+        return 0;
+    LazyTypeTable& table = iter->second;
+    std::map<int, LazyType>::iterator typeIter = table.pending.find(index);
+    if (typeIter == table.pending.end())
+        return 0;
+
+    // Entries without init function are filled by the initialization of their owner.
+    LazyType lazyType = typeIter->second;
+    if (!lazyType.initFunction)
+        return initLazyType(types, lazyType.ownerIndex) ? types[index] : 0;
+
+    table.pending.erase(typeIter);
+    if (!lazyType.name.empty())
+        table.names.erase(lazyType.name);
+
+    PyObject* scope = table.module;
+    if (lazyType.ownerIndex >= 0) {
+        PyTypeObject* enclosingType = initLazyType(types, lazyType.ownerIndex);
+        if (!enclosingType)
+            return 0;
+        scope = enclosingType->tp_dict;
+    }
+
+    // The type may be needed while some error is being handled, like in a
+    // conversion done to report the error, so the current error is kept aside.
+    PyObject* errorType;
+    PyObject* errorValue;
+    PyObject* errorTraceback;
+    PyErr_Fetch(&errorType, &errorValue, &errorTraceback);
+
+    lazyType.initFunction(scope);
+
+    // Inner types and the enums declared in the type come along with it.
+    std::map<int, LazyType>::iterator it = table.pending.begin();
+    while (it != table.pending.end()) {
+        if (it->second.ownerIndex != index) {
+            ++it;
+        } else if (it->second.initFunction) {
+            int innerIndex = it->first;
+            initLazyType(types, innerIndex);
+            it = table.pending.upper_bound(innerIndex);
+        } else {
+            table.pending.erase(it++);
+        }
+    }
+
+    if (PyErr_Occurred() || !types[index]) {
+        // The error of the failed initialization replaces the one kept aside.
+        Py_XDECREF(errorType);
+        Py_XDECREF(errorValue);
+        Py_XDECREF(errorTraceback);
+        if (!PyErr_Occurred() && lazyType.name.empty())
+            PyErr_Format(PyExc_ImportError, "can't initialize lazy inner type %d", index);
+        else if (!PyErr_Occurred())
+            PyErr_Format(PyExc_ImportError, "can't initialize lazy type '%s'", lazyType.name.c_str());
+        return 0;
+    }
+    PyErr_Restore(errorType, errorValue, errorTraceback);
+
+    // From now on the subtypes waiting for this type are found by the type itself.
+    LazySubTypesBySlotMap::iterator subTypesIter = lazySubTypesBySlot.find(TypeSlot(types, index));
+    if (subTypesIter != lazySubTypesBySlot.end()) {
+        lazySubTypes[types[index]].splice(lazySubTypes[types[index]].end(), subTypesIter->second);
+        lazySubTypesBySlot.erase(subTypesIter);
+    }
+    return types[index];
+}
+
+/// Duration of a step of a module initialization, or of the whole of it when the step is empty.
+struct InitStepTime
+{
+    std::string moduleName;
+    std::string step;
+    // In CallStatistics::ticks() units.
+    unsigned PY_LONG_LONG time;
+};
+
+// Only changed during module initialization, with the GIL held.
+static std::vector<InitStepTime>* initStepTimes = 0;
+static int startupProfileSteps = -1;
+
+static bool longerInitStep(const InitStepTime& a, const InitStepTime& b)
+{
+    return a.time > b.time;
+}
+
+static void writeStartupProfile()
+{
+    std::vector<InitStepTime> modules;
+    std::vector<InitStepTime> steps;
+    for (std::size_t i = 0; i < initStepTimes->size(); ++i)
+        ((*initStepTimes)[i].step.empty() ? modules : steps).push_back((*initStepTimes)[i]);
+    std::sort(modules.begin(), modules.end(), longerInitStep);
+    std::sort(steps.begin(), steps.end(), longerInitStep);
+
+    double millisecondsPerTick = CallStatistics::secondsPerTick() * 1e3;
+    fprintf(stderr, "Module initialization time: ms, module\n");
+    for (std::size_t i = 0; i < modules.size(); ++i)
+        fprintf(stderr, "%12.3f %s\n", modules[i].time * millisecondsPerTick, modules[i].moduleName.c_str());
+    fprintf(stderr, "Slowest module initialization steps: ms, module, step\n");
+    for (std::size_t i = 0; i < steps.size() && int(i) < startupProfileSteps; ++i)
+        fprintf(stderr, "%12.3f %s %s\n", steps[i].time * millisecondsPerTick, steps[i].moduleName.c_str(), steps[i].step.c_str());
+    delete initStepTimes;
+    initStepTimes = 0;
+}
+
+static bool startupProfileEnabled()
+{
+    if (startupProfileSteps < 0) {
+        // Any value other than a positive number of steps shows the default 20 steps.
+        const char* steps = getenv("SHIBOKEN_STARTUP_PROFILE");
+        startupProfileSteps = steps ? (atoi(steps) > 0 ? atoi(steps) : 20) : 0;
+        if (startupProfileSteps) {
+            CallStatistics::calibrate();
+            initStepTimes = new std::vector<InitStepTime>;
+            Py_AtExit(writeStartupProfile);
+        }
+    }
+    return startupProfileSteps && initStepTimes;
+}
+
+static void addInitStepTime(const char* moduleName, const char* step, unsigned PY_LONG_LONG time)
+{
+    InitStepTime stepTime;
+    stepTime.moduleName = moduleName;
+    stepTime.step = step;
+    stepTime.time = time;
+    initStepTimes->push_back(stepTime);
+}
+
+InitTimer::InitTimer(const char* moduleName) : m_moduleName(0), m_step(0), m_stepStart(0), m_moduleStart(0)
+{
+    if (startupProfileEnabled()) {
+        m_moduleName = moduleName;
+        m_moduleStart = CallStatistics::ticks();
+    }
+}
+
+InitTimer::~InitTimer()
+{
+    finish();
+}
+
+void InitTimer::step(const char* name)
+{
+    if (!m_moduleName || !initStepTimes)
+        return;
+    unsigned PY_LONG_LONG now = CallStatistics::ticks();
+    if (m_step)
+        addInitStepTime(m_moduleName, m_step, now - m_stepStart);
+    m_step = name;
+    m_stepStart = now;
+}
+
+void InitTimer::finish()
+{
+    if (!m_moduleName || !initStepTimes)
+        return;
+    unsigned PY_LONG_LONG now = CallStatistics::ticks();
+    if (m_step)
+        addInitStepTime(m_moduleName, m_step, now - m_stepStart);
+    addInitStepTime(m_moduleName, "", now - m_moduleStart);
+    m_moduleName = 0;
+    m_step = 0;
+}
+
+void loadAllTypes(PyTypeObject** types)
+{
+    LazyTypesMap::iterator iter = lazyTypes.find(types);
+    if (iter == lazyTypes.end())
+        return;
+    LazyTypeTable& table = iter->second;
+    while (!table.pending.empty()) {
+        std::map<int, LazyType>::iterator it = table.pending.begin();
+        int index = it->first;
+        if (it->second.initFunction)
+            initLazyType(types, index);
+        table.pending.erase(index);
+    }
+}
+
 } } // namespace Shiboken::Module
@@ -68,12 +68,106 @@ LIBSHIBOKEN_API PyObject* create(const char* moduleName, void* moduleData);
 LIBSHIBOKEN_API void registerTypes(PyObject* module, PyTypeObject** types);
 
 /**
- *  Retrieves the array of types.
+ *  Retrieves the array of types, the lazy types of \p module are initialized before returning.
  *  \param module   Module where the types were created.
  *  \returns        A pointer to the PyTypeObject* array of types.
  */
 LIBSHIBOKEN_API PyTypeObject** getTypes(PyObject* module);
 
+/**
+ *  Function used to initialize a type whose creation was deferred, it receives the module
+ *  or the dictionary of the enclosing type where the new type must be inserted.
+ */
+typedef void (*TypeInitFunction)(PyObject*);
+
+/**
+ *  Registers a type that will only be initialized when it's first needed: on the first access
+ *  to the attribute \p name of \p module, or when the generated code asks for it through
+ *  loadType(), as it happens on the first C++ to Python conversion of one of its instances.
+ *  \param module          Module that owns the types array.
+ *  \param types           Array of types of \p module.
+ *  \param name            Name of the type in \p module, or NULL for inner types.
+ *  \param index           Index of the type in \p types.
+ *  \param initFunction    Function that creates the type and stores it in \p types.
+ *  \param enclosingIndex  Index of the enclosing type for inner types, or -1 for module level types.
+ */
+LIBSHIBOKEN_API void registerLazyType(PyObject* module, PyTypeObject** types, const char* name, int index,
+                                      TypeInitFunction initFunction, int enclosingIndex = -1);
+
+/**
+ *  Tells that the lazy type at \p index of \p types inherits the type at \p baseIndex of \p baseTypes,
+ *  which may belong to another module. Type discovery needs the subtypes of a type to find the
+ *  most derived type of an instance, so loadLazySubTypes() initializes them beforehand.
+ */
+LIBSHIBOKEN_API void registerLazySubType(PyTypeObject** baseTypes, int baseIndex, PyTypeObject** types, int index);
+
+/**
+ *  Initializes the lazy types that inherit \p type, directly or not.
+ *  \returns false, with a Python error set, if some of them failed to initialize.
+ */
+LIBSHIBOKEN_API bool loadLazySubTypes(PyTypeObject* type);
+
+/**
+ *  Tells that the entry \p index of \p types, e.g. an enum declared inside a class, is filled when
+ *  the lazy type at \p ownerIndex is initialized.
+ */
+LIBSHIBOKEN_API void registerLazyTypeIndex(PyTypeObject** types, int index, int ownerIndex);
+
+/**
+ *  Initializes the lazy type at \p index of \p types, along with its base and enclosing types.
+ *  Use loadType() instead, it only calls this when the type wasn't created yet.
+ *  \returns the type, or NULL with a Python error set if its initialization failed.
+ */
+LIBSHIBOKEN_API PyTypeObject* initLazyType(PyTypeObject** types, int index);
+
+/**
+ *  Returns the type at \p index of the types array of a module, initializing it if
+ *  it was registered with registerLazyType() and not used until now.
+ */
+inline PyTypeObject* loadType(PyTypeObject** types, int index)
+{
+    PyTypeObject* type = types[index];
+    return type ? type : initLazyType(types, index);
+}
+
+/**
+ *  Initializes all the lazy types still pending on \p types.
+ */
+LIBSHIBOKEN_API void loadAllTypes(PyTypeObject** types);
+
+/**
+ *  Same as getTypes(), but doesn't initialize the lazy types of \p module, the caller must
+ *  access the types array through loadType().
+ */
+LIBSHIBOKEN_API PyTypeObject** getLazyTypes(PyObject* module);
+
+/**
+ *  Measures the steps of the initialization of a module, for the report enabled by the
+ *  SHIBOKEN_STARTUP_PROFILE environment variable, set to the number of steps to show.
+ *  The slowest steps of all modules and the total time of each module are written to
+ *  stderr when the interpreter exits. The time of a step importing another module
+ *  includes the initialization of that module.
+ *  Bindings use it when generated with the "startup-profile" option.
+ */
+class LIBSHIBOKEN_API InitTimer
+{
+public:
+    explicit InitTimer(const char* moduleName);
+    ~InitTimer();
+    /// Ends the current step, if any, and starts the step \p name.
+    void step(const char* name);
+    /// Ends the current step and the module initialization.
+    void finish();
+private:
+    const char* m_moduleName;
+    const char* m_step;
+    unsigned PY_LONG_LONG m_stepStart;
+    unsigned PY_LONG_LONG m_moduleStart;
+
+    InitTimer(const InitTimer&);
+    InitTimer& operator=(const InitTimer&);
+};
+
 } } // namespace Shiboken::Module
 
 #endif // SBK_MODULE_H
@@ -0,0 +1,219 @@
+/*
+ * This file is part of the Shiboken Python Bindings Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sbktrace.h"
+#include "callstatistics.h"
+#include <pythread.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#define SBK_THREAD_LOCAL __declspec(thread)
+#else
+#include <unistd.h>
+#define SBK_THREAD_LOCAL __thread
+#endif
+
+namespace Shiboken
+{
+namespace Trace
+{
+
+bool enabledFlag = false;
+
+struct TraceEvent
+{
+    unsigned PY_LONG_LONG ticks;
+    const void* object;
+    const void* related;
+    int type;
+    char name[36];
+};
+
+// Ring buffer of a thread, written only by it. The buffers are never freed, so the
+// events of the threads that already finished are dumped too, but at most
+// maxThreadTraces of them are allocated.
+struct ThreadTrace
+{
+    unsigned long threadId;
+    // Number of events recorded by the thread, the last eventsPerThread of them are kept.
+    unsigned long recorded;
+    TraceEvent* events;
+    ThreadTrace* next;
+};
+
+static const char* eventNames[] = {
+    "wrapper created",
+    "wrapper destroyed",
+    "ownership transferred",
+    "parent set",
+    "virtual override dispatched",
+    "GIL acquired",
+    "GIL released"
+};
+
+static bool initialized = false;
+static unsigned long eventsPerThread = 16384;
+static unsigned long maxThreadTraces = 16;
+static unsigned PY_LONG_LONG startTicks = 0;
+static const char* traceFileName = 0;
+// Protects the list of buffers, it's only taken when a thread records its first event and by dump().
+static PyThread_type_lock threadTracesMutex = 0;
+static ThreadTrace* threadTraces = 0;
+static unsigned long threadTraceCount = 0;
+// Threads that recorded events after all the buffers were taken, their events are dropped.
+static unsigned long untracedThreads = 0;
+// Current trace of the threads without a buffer.
+static ThreadTrace untracedThread;
+static SBK_THREAD_LOCAL ThreadTrace* currentThreadTrace = 0;
+
+static void writeTraceFile()
+{
+    if (!dump(traceFileName))
+        fprintf(stderr, "Could not write the Shiboken trace to %s\n", traceFileName);
+}
+
+void init()
+{
+    if (initialized)
+        return;
+    initialized = true;
+    const char* eventCount = getenv("SHIBOKEN_TRACE_EVENTS");
+    if (eventCount && atol(eventCount) > 0)
+        eventsPerThread = atol(eventCount);
+    const char* threadCount = getenv("SHIBOKEN_TRACE_THREADS");
+    if (threadCount && atol(threadCount) > 0)
+        maxThreadTraces = atol(threadCount);
+    traceFileName = getenv("SHIBOKEN_TRACE");
+    if (traceFileName && traceFileName[0]) {
+        setEnabled(true);
+        Py_AtExit(writeTraceFile);
+    }
+}
+
+void setEnabled(bool enabled)
+{
+    if (enabled && !threadTracesMutex) {
+        threadTracesMutex = PyThread_allocate_lock();
+        CallStatistics::calibrate();
+        startTicks = CallStatistics::ticks();
+    }
+    enabledFlag = enabled && threadTracesMutex;
+}
+
+static ThreadTrace* newThreadTrace()
+{
+    PyThread_acquire_lock(threadTracesMutex, WAIT_LOCK);
+    if (threadTraceCount >= maxThreadTraces) {
+        untracedThreads++;
+        PyThread_release_lock(threadTracesMutex);
+        return &untracedThread;
+    }
+    threadTraceCount++;
+    PyThread_release_lock(threadTracesMutex);
+
+    ThreadTrace* trace = new ThreadTrace;
+    trace->threadId = static_cast<unsigned long>(PyThread_get_thread_ident());
+    trace->recorded = 0;
+    trace->events = new TraceEvent[eventsPerThread];
+    PyThread_acquire_lock(threadTracesMutex, WAIT_LOCK);
+    trace->next = threadTraces;
+    threadTraces = trace;
+    PyThread_release_lock(threadTracesMutex);
+    return trace;
+}
+
+void record(EventType type, const void* object, const char* name, const void* related)
+{
+    ThreadTrace* trace = currentThreadTrace;
+    if (!trace)
+        trace = currentThreadTrace = newThreadTrace();
+    if (trace == &untracedThread)
+        return;
+    TraceEvent& event = trace->events[trace->recorded % eventsPerThread];
+    event.ticks = CallStatistics::ticks();
+    event.type = type;
+    event.object = object;
+    event.related = related;
+    event.name[0] = '\0';
+    if (name) {
+        strncpy(event.name, name, sizeof(event.name) - 1);
+        event.name[sizeof(event.name) - 1] = '\0';
+    }
+    trace->recorded++;
+}
+
+// Type and method names don't need escaping, anything odd is replaced anyway to keep the JSON valid.
+static void writeName(FILE* file, const char* name)
+{
+    for (; *name; ++name)
+        fputc((*name == '"' || *name == '\\' || static_cast<unsigned char>(*name) < ' ') ? '?' : *name, file);
+}
+
+bool dump(const char* fileName)
+{
+    FILE* file = fopen(fileName, "w");
+    if (!file)
+        return false;
+
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = getpid();
+#endif
+    fputs("{\"traceEvents\":[", file);
+    const char* separator = "\n";
+    unsigned long droppedThreads = 0;
+    if (threadTracesMutex) {
+        double microsecondsPerTick = CallStatistics::secondsPerTick() * 1e6;
+        PyThread_acquire_lock(threadTracesMutex, WAIT_LOCK);
+        for (const ThreadTrace* trace = threadTraces; trace; trace = trace->next) {
+            unsigned long recorded = trace->recorded;
+            unsigned long first = recorded > eventsPerThread ? recorded - eventsPerThread : 0;
+            for (unsigned long i = first; i < recorded; ++i) {
+                const TraceEvent& event = trace->events[i % eventsPerThread];
+                double timestamp = double(static_cast<PY_LONG_LONG>(event.ticks - startTicks)) * microsecondsPerTick;
+                fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"shiboken\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+                              "\"pid\":%lu,\"tid\":%lu,\"args\":{\"object\":\"%p\"",
+                        separator, eventNames[event.type], timestamp, pid, trace->threadId, event.object);
+                if (event.name[0]) {
+                    fputs(",\"name\":\"", file);
+                    writeName(file, event.name);
+                    fputc('"', file);
+                }
+                if (event.related)
+                    fprintf(file, ",\"related\":\"%p\"", event.related);
+                fputs("}}", file);
+                separator = ",\n";
+            }
+        }
+        droppedThreads = untracedThreads;
+        PyThread_release_lock(threadTracesMutex);
+    }
+    fprintf(file, "\n],\"otherData\":{\"untraced_threads\":%lu}}\n", droppedThreads);
+    return fclose(file) == 0;
+}
+
+} // namespace Trace
+} // namespace Shiboken
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the Shiboken Python Bindings Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SBKTRACE_H
+#define SBKTRACE_H
+
+#include "sbkpython.h"
+#include "shibokenmacros.h"
+
+namespace Shiboken
+{
+
+/**
+ *  Tracing of the wrapper lifetime and GIL events, available in release builds. Each thread
+ *  records the events in its own ring buffer, keeping the latest ones, without locking nor
+ *  formatting anything. The buffers are written in the Chrome trace event format, readable by
+ *  chrome://tracing, by dump().
+ *
+ *  It's enabled by the SHIBOKEN_TRACE environment variable, set to the name of the file written
+ *  when the interpreter exits. SHIBOKEN_TRACE_EVENTS sets the number of events kept by each thread,
+ *  16384 by default, and SHIBOKEN_TRACE_THREADS the number of threads with a buffer, 16 by default.
+ *  On 64 bit systems each event takes 64 bytes, 1 MB per thread and 16 MB in total by default,
+ *  and the buffers are kept until the process exits. The events of the threads started after all
+ *  the buffers were taken are dropped, their number is written with the trace.
+ */
+namespace Trace
+{
+
+enum EventType
+{
+    WrapperCreated,
+    WrapperDestroyed,
+    /// The name tells if the C++ object ownership went to Python or to C++.
+    OwnershipTransferred,
+    /// The related object is the new parent, or null when the parent is removed.
+    ParentSet,
+    /// A C++ virtual method call was dispatched to the Python override with the given name.
+    VirtualOverrideDispatched,
+    GilAcquired,
+    GilReleased
+};
+
+/// \internal Use isEnabled().
+extern LIBSHIBOKEN_API bool enabledFlag;
+
+inline bool isEnabled()
+{
+    return enabledFlag;
+}
+
+/// Reads the environment variables, it's done by Shiboken::init().
+LIBSHIBOKEN_API void init();
+
+/// Starts or stops recording events, the events already recorded are kept.
+LIBSHIBOKEN_API void setEnabled(bool enabled);
+
+/// \internal Use event().
+LIBSHIBOKEN_API void record(EventType type, const void* object, const char* name, const void* related);
+
+/**
+ *  Records an event of the current thread, if tracing is enabled. It can be called without the GIL.
+ *  \param object   the wrapper the event is about, if any.
+ *  \param name     a type or method name, copied and truncated to a few dozen characters.
+ *  \param related  another object involved in the event, e.g. the parent.
+ */
+inline void event(EventType type, const void* object = 0, const char* name = 0, const void* related = 0)
+{
+    if (enabledFlag)
+        record(type, object, name, related);
+}
+
+/**
+ *  Writes the events recorded by all the threads to \p fileName, in the Chrome trace event format.
+ *  Events recorded by other threads while writing may come out garbled.
+ *  \returns false if the file couldn't be written.
+ */
+LIBSHIBOKEN_API bool dump(const char* fileName);
+
+} // namespace Trace
+} // namespace Shiboken
+
+#endif // SBKTRACE_H
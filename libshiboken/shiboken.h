@@ -27,13 +27,16 @@
 #include "autodecref.h"
 #include "basewrapper.h"
 #include "bindingmanager.h"
+#include "callstatistics.h"
 #include "conversions.h"
 #include "gilstate.h"
 #include "threadstatesaver.h"
 #include "helper.h"
+#include "sbkasync.h"
 #include "sbkenum.h"
 #include "sbkmodule.h"
 #include "sbkstring.h"
+#include "sbktrace.h"
 #include "shibokenmacros.h"
 #include "typeresolver.h"
 #include "shibokenbuffer.h"
@@ -43,4 +43,13 @@
     #define SBK_DEPRECATED(func) func
 #endif
 
+// SBK_MOVE turns a value into an rvalue when the compiler supports move semantics, allowing
+// the converters to steal the contents of temporaries instead of copying them.
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+    #define SBK_HAS_RVALUE_REFERENCES
+    #define SBK_MOVE(value) std::move(value)
+#else
+    #define SBK_MOVE(value) value
+#endif
+
 #endif
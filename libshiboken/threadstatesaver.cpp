@@ -21,6 +21,7 @@
  */
 
 #include "threadstatesaver.h"
+#include "sbktrace.h"
 
 namespace Shiboken
 {
@@ -36,8 +37,10 @@ ThreadStateSaver::~ThreadStateSaver()
 
 void ThreadStateSaver::save()
 {
-    if (PyEval_ThreadsInitialized())
+    if (PyEval_ThreadsInitialized()) {
+        Trace::event(Trace::GilReleased);
         m_threadState = PyEval_SaveThread();
+    }
 }
 
 void ThreadStateSaver::restore()
@@ -45,6 +48,7 @@ void ThreadStateSaver::restore()
     if (m_threadState) {
         PyEval_RestoreThread(m_threadState);
         m_threadState = 0;
+        Trace::event(Trace::GilAcquired);
     }
 }
 
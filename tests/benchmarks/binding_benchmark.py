@@ -0,0 +1,219 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+
+'''Measures the overhead of the binding runtime on calls, conversions and wrappers.
+
+Usage: binding_benchmark.py [options]
+
+  --output <file>     Write the results as JSON to file instead of the standard output.
+  --compare <file>    Compare the results with a previous JSON output and report the
+                      benchmarks that got significantly slower or faster.
+  --filter <regexp>   Run only the benchmarks whose names match regexp.
+  --repeat <number>   Number of timed repetitions of each benchmark, 20 by default.
+  --path <dir>        Directory to search for the binding modules, may be repeated.
+
+Each repetition runs a benchmark enough times to last at least 20 ms and the
+time per call of each repetition is kept in the output. Comparisons apply a
+Mann-Whitney U test to the repetitions, so changes smaller than the noise of
+the machine are not reported. Exits with 1 if a benchmark got slower.
+'''
+
+import json
+import math
+import os
+import platform
+import re
+import sys
+import time
+
+MIN_REPETITION_TIME = 0.02
+SIGNIFICANCE = 2.58 # 99% two-sided, normal approximation
+MIN_CHANGE = 0.05
+
+timer = time.perf_counter if hasattr(time, 'perf_counter') else time.time
+
+def benchmarks():
+    '''Returns a list of (name, function) pairs, each function measured with no arguments.'''
+    from sample import (Point, Overload, ObjectType, VirtualMethods, ListUser,
+                        MDerived1, SampleNamespace, Str)
+
+    class PythonVirtualMethods(VirtualMethods):
+        def sum0(self, a0, a1, a2):
+            return a0
+
+    point = Point(1, 2)
+    overload = Overload()
+    obj = ObjectType()
+    parents = (ObjectType(), ObjectType())
+    child = ObjectType(parents[0])
+    virtualMethods = VirtualMethods()
+    pythonVirtualMethods = PythonVirtualMethods()
+    listUser = ListUser()
+    mderived = MDerived1()
+    option = SampleNamespace.Option(1)
+    name = Str('name')
+
+    def reparent():
+        child.setParent(parents[1])
+        child.setParent(parents[0])
+
+    result = [
+        ('call_0_args',                 lambda: point.x()),
+        ('call_1_arg',                  lambda: point.setX(1.0)),
+        ('call_3_args',                 lambda: virtualMethods.callSum1(1, 2, 3)),
+        ('call_overloaded',             lambda: overload.intOverloads(2, 3)),
+        ('call_overloaded_6_args',      lambda: overload.drawText(1, 2, 3, 4, 5, name)),
+        ('call_keyword_args',           lambda: obj.setObjectNameWithSize(name=name, size=4)),
+        ('virtual_not_overridden',      lambda: virtualMethods.callSum0(1, 2, 3)),
+        ('virtual_overridden',          lambda: pythonVirtualMethods.callSum0(1, 2, 3)),
+        ('value_type_create_destroy',   lambda: Point(1, 2)),
+        ('object_type_create_destroy',  lambda: ObjectType()),
+        ('enum_argument',               lambda: SampleNamespace.getNumber(option)),
+        ('reparent_twice',              reparent),
+        ('multiple_inheritance_cast',   lambda: mderived.castToBase2()),
+    ]
+    for size in (1, 10, 100, 1000):
+        values = list(range(size))
+        result.append(('list_to_cpp_%d' % size, lambda values=values: listUser.sumList(values)))
+        result.append(('list_to_python_%d' % size, lambda values=values: (listUser.setList(values), listUser.getList())))
+    return result
+
+def calibrate(function):
+    '''Returns the number of calls needed to last MIN_REPETITION_TIME.'''
+    loops = 1
+    while True:
+        if measure(function, loops) * loops >= MIN_REPETITION_TIME:
+            return loops
+        loops *= 2
+
+def measure(function, loops):
+    '''Returns the time per call, in seconds, of calling function loops times.'''
+    iterations = range(loops)
+    start = timer()
+    for i in iterations:
+        function()
+    return (timer() - start) / loops
+
+def summary(samples):
+    samples = sorted(samples)
+    count = len(samples)
+    mean = sum(samples) / count
+    stdev = math.sqrt(sum([(x - mean) ** 2 for x in samples]) / (count - 1)) if count > 1 else 0.0
+    return {'min': samples[0], 'median': samples[count // 2], 'mean': mean, 'stdev': stdev}
+
+def run(pattern, repeat):
+    results = {}
+    for name, function in benchmarks():
+        if pattern and not re.search(pattern, name):
+            continue
+        loops = calibrate(function)
+        samples = [measure(function, loops) for i in range(repeat)]
+        result = summary(samples)
+        result['loops'] = loops
+        result['samples'] = samples
+        results[name] = result
+        sys.stderr.write('%-30s %10.1f ns\n' % (name, result['median'] * 1e9))
+    return results
+
+def mannWhitneyZ(a, b):
+    '''Returns the z score of the Mann-Whitney U test, positive when b is slower than a.'''
+    ranked = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks = [0.0] * len(ranked)
+    i = 0
+    while i < len(ranked):
+        j = i
+        while j + 1 < len(ranked) and ranked[j + 1][0] == ranked[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        i = j + 1
+    n1, n2 = len(a), len(b)
+    rankSumB = sum([rank for rank, (value, group) in zip(ranks, ranked) if group == 1])
+    u = rankSumB - n2 * (n2 + 1) / 2.0
+    sigma = math.sqrt(n1 * n2 * (n1 + n2 + 1) / 12.0)
+    return (u - n1 * n2 / 2.0) / sigma if sigma else 0.0
+
+def compare(base, current):
+    '''Prints the significant changes, returns True if a benchmark got slower.'''
+    slower = False
+    for name in sorted(current['benchmarks']):
+        if name not in base['benchmarks']:
+            continue
+        old = base['benchmarks'][name]
+        new = current['benchmarks'][name]
+        change = new['median'] / old['median'] - 1
+        z = mannWhitneyZ(old['samples'], new['samples'])
+        if abs(z) < SIGNIFICANCE or abs(change) < MIN_CHANGE:
+            status = ''
+        elif change > 0:
+            status = 'SLOWER'
+            slower = True
+        else:
+            status = 'faster'
+        print('%-30s %10.1f ns %10.1f ns %+7.1f%%  %s' % (name, old['median'] * 1e9, new['median'] * 1e9, change * 100, status))
+    return slower
+
+def main(argv):
+    options = {'--output': None, '--compare': None, '--filter': None, '--repeat': '20'}
+    paths = []
+    args = argv[1:]
+    while args:
+        option = args.pop(0)
+        if not args or (option not in options and option != '--path'):
+            sys.stderr.write(__doc__)
+            return 2
+        if option == '--path':
+            paths.append(args.pop(0))
+        else:
+            options[option] = args.pop(0)
+    for path in reversed(paths):
+        sys.path.insert(0, path)
+        os.environ['PATH'] = path + os.pathsep + os.environ.get('PATH', '')
+
+    current = {
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'benchmarks': run(options['--filter'], int(options['--repeat'])),
+    }
+    output = json.dumps(current, indent=1, sort_keys=True)
+    if options['--output']:
+        f = open(options['--output'], 'w')
+        f.write(output)
+        f.close()
+    elif not options['--compare']:
+        print(output)
+
+    if options['--compare']:
+        f = open(options['--compare'])
+        base = json.load(f)
+        f.close()
+        if compare(base, current):
+            return 1
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Measures the time taken to import a binding module.
+
+Usage: import_benchmark.py [module] [runs]
+
+Each run imports the module in a new interpreter, so build the bindings with
+and without --lazy-type-init and compare the results. Remember to set
+PYTHONPATH and the library path as done for the tests.
+'''
+
+import subprocess
+import sys
+
+CODE = ('import time\n'
+        'start = time.time()\n'
+        'import %s\n'
+        'print(time.time() - start)\n')
+
+def importTime(module):
+    process = subprocess.Popen([sys.executable, '-c', CODE % module], stdout=subprocess.PIPE)
+    output = process.communicate()[0]
+    if process.returncode != 0:
+        raise RuntimeError('could not import %s' % module)
+    return float(output.decode().strip())
+
+def main(argv):
+    module = argv[1] if len(argv) > 1 else 'sample'
+    runs = int(argv[2]) if len(argv) > 2 else 20
+    times = sorted([importTime(module) for i in range(runs)])
+    print('%s: %d runs' % (module, runs))
+    print('  min:    %.2f ms' % (times[0] * 1000))
+    print('  median: %.2f ms' % (times[len(times) // 2] * 1000))
+    print('  max:    %.2f ms' % (times[-1] * 1000))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
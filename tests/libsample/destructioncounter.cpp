@@ -0,0 +1,48 @@
+/*
+ * This file is part of the Shiboken Python Binding Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include "destructioncounter.h"
+
+int DestructionCounter::m_created = 0;
+int DestructionCounter::m_destroyed = 0;
+
+DestructionCounter::DestructionCounter()
+{
+    ++m_created;
+}
+
+DestructionCounter::~DestructionCounter()
+{
+    ++m_destroyed;
+}
+
+int BackgroundDestructionCounter::m_created = 0;
+int BackgroundDestructionCounter::m_destroyed = 0;
+
+BackgroundDestructionCounter::BackgroundDestructionCounter()
+{
+    ++m_created;
+}
+
+BackgroundDestructionCounter::~BackgroundDestructionCounter()
+{
+    ++m_destroyed;
+}
@@ -0,0 +1,60 @@
+/*
+ * This file is part of the Shiboken Python Binding Generator project.
+ *
+ * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: PySide team <contact@pyside.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef DESTRUCTIONCOUNTER_H
+#define DESTRUCTIONCOUNTER_H
+
+#include "libsamplemacros.h"
+
+// Counts its destructions. The wrapper keeps a reference to the kept objects, when it dies
+// they are destroyed along with it in a single batch.
+class LIBSAMPLE_API DestructionCounter
+{
+public:
+    DestructionCounter();
+    ~DestructionCounter();
+
+    void keep(DestructionCounter* other) {}
+
+    static int createdInstances() { return m_created; }
+    static int destroyedInstances() { return m_destroyed; }
+
+private:
+    static int m_created;
+    static int m_destroyed;
+};
+
+// Declared with a thread safe destructor in the type system, it's destroyed by the destructor thread.
+class LIBSAMPLE_API BackgroundDestructionCounter
+{
+public:
+    BackgroundDestructionCounter();
+    ~BackgroundDestructionCounter();
+
+    static int createdInstances() { return m_created; }
+    static int destroyedInstances() { return m_destroyed; }
+
+private:
+    static int m_created;
+    static int m_destroyed;
+};
+
+#endif // DESTRUCTIONCOUNTER_H
@@ -51,6 +51,12 @@ ObjectType::createWithChild()
     return parent;
 }
 
+ObjectType*
+ObjectType::createLayout()
+{
+    return ObjectTypeLayout::create();
+}
+
 void
 ObjectType::removeChild(ObjectType* child)
 {
@@ -57,6 +57,10 @@ public:
     // factory method
     inline static ObjectType* create() { return new ObjectType(); }
     static ObjectType* createWithChild();
+    // Returns an ObjectTypeLayout, whose type must be discovered.
+    static ObjectType* createLayout();
+    // Deletes object, whoever owns it.
+    static void deleteObject(ObjectType* object) { delete object; }
 
     void setParent(ObjectType* parent);
     inline ObjectType* parent() const { return m_parent; }
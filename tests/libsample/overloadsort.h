@@ -78,5 +78,14 @@ public:
 
 };
 
+// Declared from the most expensive argument check to the cheapest one, which the generated code runs first.
+class CostSortedOverload
+{
+public:
+    inline const char* overload(const std::list<int>& x) { return "list(int)"; }
+    inline const char* overload(ImplicitBase x) { return "ImplicitBase"; }
+    inline const char* overload(int x) { return "int"; }
+};
+
 #endif // OVERLOADSORT_H
 
@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the class hierarchy queries, with types registered after the hierarchy was first used.'''
+
+import subprocess
+import sys
+import unittest
+
+def runInFreshInterpreter(code):
+    '''Runs code in a new interpreter, where sample and other were not imported yet.'''
+    return subprocess.call([sys.executable, '-c', code])
+
+class ClassHierarchyTest(unittest.TestCase):
+
+    def testMultipleInheritance(self):
+        '''Base classes are found on every branch of a multiple inheritance hierarchy.'''
+        code = ('from sample import MDerived1, MDerived3\n'
+                'a = MDerived3()\n'
+                'assert MDerived1.transformFromBase1(a) == a\n'
+                'assert MDerived1.transformFromBase2(a) == a\n'
+                'assert a.castToMDerived2().castToBase3() == a\n')
+        self.assertEqual(runInFreshInterpreter(code), 0)
+
+    def testTypesRegisteredLater(self):
+        '''Types of a module imported after the hierarchy was used are part of it.'''
+        code = ('from sample import MDerived1, MDerived3\n'
+                'a = MDerived3()\n'
+                'assert MDerived1.transformFromBase2(a) == a\n'
+                'from other import OtherMultipleDerived\n'
+                'b = OtherMultipleDerived()\n'
+                'assert MDerived1.transformFromBase2(b) == b\n'
+                'c = OtherMultipleDerived.createObject("OtherMultipleDerived")\n'
+                'assert type(c) is OtherMultipleDerived\n'
+                'assert type(OtherMultipleDerived.createObject("MDerived3")) is MDerived3\n')
+        self.assertEqual(runInFreshInterpreter(code), 0)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,107 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the "_async" variants of the methods that release the GIL.'''
+
+import subprocess
+import sys
+import threading
+import unittest
+
+from sample import Bucket
+
+
+class Unlocker(threading.Thread):
+
+    def __init__(self, bucket):
+        threading.Thread.__init__(self)
+        self.bucket = bucket
+
+    def run(self):
+        while not self.bucket.locked():
+            pass
+
+        self.bucket.unlock()
+
+
+class AsyncCallTest(unittest.TestCase):
+
+    def testResult(self):
+        '''The blocking call runs on a worker thread while Python unlocks it.'''
+        bucket = Bucket()
+        future = bucket.lock_async()
+        while not bucket.locked():
+            pass
+        self.assertFalse(future.done())
+        bucket.unlock()
+        self.assertEqual(future.result(), None)
+        self.assert_(future.done())
+
+    def testReturnValue(self):
+        bucket = Bucket()
+        unlocker = Unlocker(bucket)
+        unlocker.start()
+        future = bucket.callVirtualBlockerMethodButYouDontKnowThis_async()
+        self.assert_(future.result())
+        unlocker.join()
+
+    def testPendingCallsAtExit(self):
+        '''The calls still pending when the interpreter exits are finished before the workers stop.'''
+        # Registered before the worker threads start, the handler runs after they were stopped.
+        code = ('import atexit, sys\n'
+                'from sample import Bucket\n'
+                'futures = []\n'
+                'atexit.register(lambda: sys.stdout.write(str(all([f.done() for f in futures]))))\n'
+                'bucket = Bucket()\n'
+                'futures.extend([bucket.empty_async() for i in range(100)])\n')
+        process = subprocess.Popen([sys.executable, '-c', code], stdout=subprocess.PIPE)
+        output = process.communicate()[0].decode()
+        self.assertEqual(process.returncode, 0)
+        self.assertEqual(output, 'True')
+
+    def testWrongArguments(self):
+        '''Argument errors are raised by result().'''
+        future = Bucket().lock_async(1)
+        self.assertRaises(TypeError, future.result)
+
+    if sys.version_info >= (3, 5):
+        def testAwait(self):
+            import asyncio
+            bucket = Bucket()
+            unlocker = Unlocker(bucket)
+            unlocker.start()
+            loop = asyncio.new_event_loop()
+            try:
+                asyncio.set_event_loop(loop)
+                result = loop.run_until_complete(asyncio.ensure_future(bucket.callVirtualBlockerMethodButYouDontKnowThis_async()))
+            finally:
+                asyncio.set_event_loop(None)
+                loop.close()
+            unlocker.join()
+            self.assert_(result)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,97 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the call statistics of bindings generated with --call-statistics.'''
+
+import os
+import sys
+import threading
+import unittest
+
+from sample import Overload, Point, VirtualMethods, callStatistics, resetCallStatistics
+
+generatedWithCallStatistics = '--call-statistics' in os.environ.get('SHIBOKEN_GENERATOR_FLAGS', '').split()
+
+def requiresCallStatistics(test):
+    '''Skips test when sample was not generated with --call-statistics, unittest.skipUnless needs Python 2.7.'''
+    def run(self):
+        if not generatedWithCallStatistics:
+            sys.stderr.write('skipped, sample was not generated with --call-statistics ')
+            return
+        test(self)
+    run.__name__ = test.__name__
+    run.__doc__ = test.__doc__
+    return run
+
+class CallStatisticsTest(unittest.TestCase):
+
+    def setUp(self):
+        resetCallStatistics()
+
+    def functionStatistics(self, name):
+        for statistics in callStatistics():
+            if statistics['name'] == name:
+                return statistics
+        return None
+
+    @requiresCallStatistics
+    def testOverloadCalls(self):
+        overload = Overload()
+        for i in range(3):
+            overload.intOverloads(2, 3)
+        overload.intOverloads(Point(0, 0), 3)
+
+        statistics = self.functionStatistics('sample.Overload.intOverloads')
+        self.assertEqual(statistics['calls'], 4)
+        self.assertEqual(sum(statistics['overloads']), 4)
+        self.assertEqual(max(statistics['overloads']), 3)
+        self.assert_(statistics['time'] >= statistics['gil_released_time'] >= 0)
+        self.assert_(self.functionStatistics('sample.Overload.__init__'))
+
+    @requiresCallStatistics
+    def testVirtualCallsFromThreads(self):
+        '''Virtual methods without a Python override, called by C++ from several threads.'''
+        def callVirtual():
+            obj = VirtualMethods()
+            for i in range(1000):
+                obj.callSum0(1, 2, 3)
+        threads = [threading.Thread(target=callVirtual) for i in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        statistics = self.functionStatistics('virtual VirtualMethods::sum0(int,int,int)')
+        self.assertEqual(statistics['calls'], 4000)
+        self.assert_(statistics['time'] >= 0)
+
+    def testReset(self):
+        Point(1, 2)
+        resetCallStatistics()
+        self.assertEqual(self.functionStatistics('sample.Point.__init__'), None)
+
+if __name__ == '__main__':
+    unittest.main()
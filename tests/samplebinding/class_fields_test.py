@@ -89,6 +89,17 @@ class TestAccessingCppFields(unittest.TestCase):
         # attribution with invalid type
         self.assertRaises(TypeError, lambda : setattr(d, 'valueTypeField', 123))
 
+    def testValueTypeFieldWrapperIsReused(self):
+        '''Reading a value type field many times should return the same wrapper.'''
+        d = Derived()
+        field = d.valueTypeField
+        self.assertTrue(d.valueTypeField is field)
+        d.valueTypeField = Point(3, 4)
+        self.assertTrue(d.valueTypeField is field)
+        self.assertEqual(field, Point(3, 4))
+        del d
+        self.assertRaises(RuntimeError, field.x)
+
     def testAccessingObjectTypeField(self):
         '''Reads and writes a object type (in this case an 'ObjectType') field.'''
         d = Derived()
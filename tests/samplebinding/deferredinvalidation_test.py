@@ -0,0 +1,87 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the invalidation of wrappers whose C++ objects are destroyed without the GIL.'''
+
+import threading
+import unittest
+
+from sample import ObjectType, cacheSize, setDeferredInvalidation
+
+class DeferredInvalidationTest(unittest.TestCase):
+    '''ObjectType.killChild deletes the child while the GIL is released.'''
+
+    def setUp(self):
+        setDeferredInvalidation(True)
+
+    def tearDown(self):
+        setDeferredInvalidation(False)
+
+    def testInvalidatedOnUse(self):
+        parent = ObjectType()
+        child = ObjectType(parent)
+        child.setObjectName('child')
+        parent.killChild('child')
+        self.assertRaises(RuntimeError, child.objectName)
+
+    def testReusedAddress(self):
+        '''A new object created where a destroyed one lived gets its own wrapper.'''
+        parent = ObjectType()
+        for i in range(10):
+            child = ObjectType(parent)
+            child.setObjectName('child')
+            parent.killChild('child')
+            other = ObjectType(parent)
+            other.setObjectName('other')
+            self.assertEqual(parent.findChild('other'), other)
+            self.assertRaises(RuntimeError, child.objectName)
+            parent.killChild('other')
+
+    def testWrappersReleased(self):
+        parent = ObjectType()
+        size = cacheSize()
+        child = ObjectType(parent)
+        child.setObjectName('child')
+        parent.killChild('child')
+        del child
+        setDeferredInvalidation(False)
+        self.assertEqual(cacheSize(), size)
+
+    def testPythonOwnedObjectDeletedByCpp(self):
+        '''The wrapper of a Python owned object deleted by C++ doesn't delete it again.'''
+        size = cacheSize()
+        def deleteAndDrop():
+            # The pending call that invalidates the wrapper only runs in the main thread.
+            obj = ObjectType()
+            ObjectType.deleteObject(obj)
+            del obj
+        thread = threading.Thread(target=deleteAndDrop)
+        thread.start()
+        thread.join()
+        self.assertEqual(cacheSize(), size)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,84 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the destruction of the C++ objects owned by Python.'''
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+from sample import DestructionCounter, dumpTrace, setTraceEnabled
+
+class DestructionBatchTest(unittest.TestCase):
+    '''The C++ objects owned by a dying wrapper are destroyed when the batch ends.'''
+
+    def gilReleases(self):
+        fd, fileName = tempfile.mkstemp(suffix='.json')
+        os.close(fd)
+        try:
+            self.assert_(dumpTrace(fileName))
+            events = json.load(open(fileName))['traceEvents']
+        finally:
+            os.remove(fileName)
+        return len([event for event in events if event['name'] == 'GIL released'])
+
+    def testKeptObjectsDestroyedWithKeeper(self):
+        keeper = DestructionCounter()
+        for i in range(10):
+            keeper.keep(DestructionCounter())
+        destroyed = DestructionCounter.destroyedInstances()
+        releases = self.gilReleases()
+
+        setTraceEnabled(True)
+        del keeper
+        setTraceEnabled(False)
+
+        self.assertEqual(DestructionCounter.destroyedInstances(), destroyed + 11)
+        self.assertEqual(DestructionCounter.destroyedInstances(), DestructionCounter.createdInstances())
+        # All the destructors were called with a single GIL release.
+        self.assertEqual(self.gilReleases(), releases + 1)
+
+class DestructorThreadTest(unittest.TestCase):
+    '''Objects with thread safe destructors are destroyed by the destructor thread.'''
+
+    def testQueuedObjectsDestroyedAtExit(self):
+        # Registered before the destructor thread starts, the handler runs after it was stopped.
+        code = ('import atexit, sys\n'
+                'from sample import BackgroundDestructionCounter as Counter\n'
+                'atexit.register(lambda: sys.stdout.write("%d %d" % (Counter.createdInstances(), '
+                'Counter.destroyedInstances())))\n'
+                'objects = [Counter() for i in range(1000)]\n'
+                'del objects\n')
+        process = subprocess.Popen([sys.executable, '-c', code], stdout=subprocess.PIPE)
+        output = process.communicate()[0].decode()
+        self.assertEqual(process.returncode, 0)
+        self.assertEqual(output, '1000 1000')
+
+if __name__ == '__main__':
+    unittest.main()
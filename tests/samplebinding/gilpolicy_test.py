@@ -0,0 +1,103 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the C++ calls releasing the GIL under each --allow-thread policy, and for the
+GIL hold report of bindings generated with --gil-hold-diagnostics.'''
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+from sample import Bucket, Point, dumpTrace, setTraceEnabled
+
+generatorFlags = os.environ.get('SHIBOKEN_GENERATOR_FLAGS', '').split()
+
+def allowThreadPolicy():
+    for flag in generatorFlags:
+        if flag.startswith('--allow-thread='):
+            return flag.split('=', 1)[1]
+    return 'all'
+
+def gilReleases(function, *args):
+    '''Returns how many times the GIL was released while calling function.'''
+    fd, fileName = tempfile.mkstemp(suffix='.json')
+    os.close(fd)
+    try:
+        setTraceEnabled(True)
+        function(*args)
+        setTraceEnabled(False)
+        dumpTrace(fileName)
+        events = json.load(open(fileName))['traceEvents']
+    finally:
+        os.remove(fileName)
+    return len([event for event in events if event['name'] == 'GIL released'])
+
+class AllowThreadPolicyTest(unittest.TestCase):
+
+    def setUp(self):
+        self.before = gilReleases(lambda: None)
+        self.policy = allowThreadPolicy()
+
+    def released(self, function, *args):
+        return gilReleases(function, *args) > self.before
+
+    def testConstantGetter(self):
+        '''Constant methods without arguments keep the GIL unless all the calls release it.'''
+        self.assertEqual(self.released(Point(1, 2).x), self.policy == 'all')
+
+    def testSetter(self):
+        '''Setters with a single argument keep the GIL unless all the calls release it.'''
+        self.assertEqual(self.released(Point(1, 2).setX, 3.0), self.policy == 'all')
+
+    def testOtherMethod(self):
+        '''Other methods release the GIL unless only the marked ones do.'''
+        self.assertEqual(self.released(Bucket().push, 1), self.policy != 'marked')
+
+    def testMarkedMethod(self):
+        '''Methods marked with allow-thread release the GIL with every policy.'''
+        self.assert_(self.released(Bucket().empty))
+
+class GilHoldReportTest(unittest.TestCase):
+
+    def testReport(self):
+        if '--gil-hold-diagnostics' not in generatorFlags:
+            sys.stderr.write('skipped, sample was not generated with --gil-hold-diagnostics ')
+            return
+        environment = dict(os.environ)
+        environment['SHIBOKEN_GIL_HOLD_REPORT'] = '1'
+        code = 'from sample import Point\nPoint(1, 2).x()\n'
+        process = subprocess.Popen([sys.executable, '-c', code], env=environment, stderr=subprocess.PIPE)
+        lines = process.communicate()[1].decode().splitlines()
+        self.assertEqual(process.returncode, 0)
+        self.assert_('Time spent in C++ calls holding the GIL: ms, calls, function' in lines)
+        if allowThreadPolicy() != 'all':
+            self.assert_([line for line in lines if line.split()[1:] == ['1', 'Point::x()']])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the GIL acquisition done by C++ code calling Python.'''
+
+import unittest
+
+from sample import Bucket, Str, VirtualMethods, gilStateCounters
+
+class NamedVirtualMethods(VirtualMethods):
+    def name(self):
+        return Str('Named')
+
+class NonBlockingBucket(Bucket):
+    def virtualBlockerMethod(self):
+        return True
+
+class GilStateTest(unittest.TestCase):
+    '''C++ calling back into Python acquires the GIL only when it doesn't hold it.'''
+
+    def testGilAlreadyHeld(self):
+        '''A virtual method called while Python holds the GIL must not acquire it again.'''
+        obj = NamedVirtualMethods()
+        acquired, alreadyHeld = gilStateCounters()
+        obj.callName()
+        newAcquired, newAlreadyHeld = gilStateCounters()
+        self.assertEqual(newAcquired, acquired)
+        self.assert_(newAlreadyHeld > alreadyHeld)
+
+    def testGilReleased(self):
+        '''A virtual method called from a method that released the GIL must acquire it.'''
+        bucket = NonBlockingBucket()
+        acquired, alreadyHeld = gilStateCounters()
+        self.assert_(bucket.callVirtualBlockerMethodButYouDontKnowThis())
+        newAcquired, newAlreadyHeld = gilStateCounters()
+        self.assert_(newAcquired > acquired)
+
+if __name__ == '__main__':
+    unittest.main()
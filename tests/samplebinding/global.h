@@ -7,6 +7,7 @@
 #include "ctorconvrule.h"
 #include "sbkdate.h"
 #include "derived.h"
+#include "destructioncounter.h"
 #include "echo.h"
 #include "functions.h"
 #include "implicitconv.h"
@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the heap snapshot of the wrapper graph.'''
+
+import json
+import os
+import tempfile
+import unittest
+
+from sample import ObjectModel, ObjectType, ObjectView, writeHeapSnapshot
+
+class HeapSnapshotTest(unittest.TestCase):
+
+    def snapshot(self):
+        fd, fileName = tempfile.mkstemp(suffix='.jsonl')
+        os.close(fd)
+        try:
+            self.assert_(writeHeapSnapshot(fileName))
+            return [json.loads(line) for line in open(fileName)]
+        finally:
+            os.remove(fileName)
+
+    def testNodesAndEdges(self):
+        parent = ObjectType()
+        child = ObjectType()
+        child.setParent(parent)
+        model = ObjectModel()
+        view = ObjectView()
+        view.setModel(model)
+
+        records = self.snapshot()
+        nodes = dict((int(record['node'], 16), record) for record in records if 'node' in record)
+        edges = [(record['edge'], int(record['from'], 16), int(record['to'], 16))
+                 for record in records if 'edge' in record]
+
+        self.assertEqual(len(nodes), len([record for record in records if 'node' in record]))
+        self.assertEqual(nodes[id(parent)]['type'], 'sample.ObjectType')
+        self.assert_(nodes[id(parent)]['owned_by_python'])
+        self.assert_(not nodes[id(child)]['owned_by_python'])
+        self.assert_(nodes[id(child)]['refcount'] >= 2)
+        self.assert_(('child', id(parent), id(child)) in edges)
+        self.assert_(('reference', id(view), id(model)) in edges)
+
+if __name__ == '__main__':
+    unittest.main()
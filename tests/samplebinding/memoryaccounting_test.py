@@ -0,0 +1,70 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the memory accounting of wrappers: __sizeof__ and the instance histogram.'''
+
+import sys
+import unittest
+
+from sample import ObjectType, Point, instanceHistogram
+
+class ExtObjectType(ObjectType):
+    pass
+
+class MemoryAccountingTest(unittest.TestCase):
+
+    def liveInstances(self, type):
+        return instanceHistogram().get(type, (0, 0))
+
+    def testSizeOfParentInfo(self):
+        parent = ObjectType()
+        size = parent.__sizeof__()
+        self.assert_(size > object().__sizeof__())
+        children = [ObjectType() for i in range(10)]
+        for child in children:
+            child.setParent(parent)
+        self.assert_(parent.__sizeof__() > size)
+        self.assert_(sys.getsizeof(parent) >= parent.__sizeof__())
+
+    def testHistogram(self):
+        count, size = self.liveInstances(Point)
+        points = [Point(i, i) for i in range(5)]
+        newCount, newSize = self.liveInstances(Point)
+        self.assertEqual(newCount, count + 5)
+        self.assert_(newSize > size)
+        del points
+        self.assertEqual(self.liveInstances(Point), (count, size))
+
+    def testHistogramCountsExactType(self):
+        count = self.liveInstances(ObjectType)[0]
+        obj = ExtObjectType()
+        self.assertEqual(self.liveInstances(ExtObjectType)[0], 1)
+        self.assertEqual(self.liveInstances(ObjectType)[0], count)
+        del obj
+        self.assert_(ExtObjectType not in instanceHistogram())
+
+if __name__ == '__main__':
+    unittest.main()
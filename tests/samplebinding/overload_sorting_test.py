@@ -78,6 +78,27 @@ class DeepOverloadSorting(unittest.TestCase):
         '''Deep Overload - (int, ImplicitBase *)'''
         self.assertEqual(self.obj.overloadDeep(1, ImplicitBase()), "ImplicitBase")
 
+class CostOverloadSorting(unittest.TestCase):
+    '''Overloads checked from the cheapest argument check, instead of the declaration order.'''
+
+    def setUp(self):
+        self.obj = CostSortedOverload()
+
+    def testInt(self):
+        self.assertEqual(self.obj.overload(3), "int")
+
+    def testImplicitConversion(self):
+        self.assertEqual(self.obj.overload(ImplicitBase()), "ImplicitBase")
+        self.assertEqual(self.obj.overload(ImplicitTarget()), "ImplicitBase")
+
+    def testSequence(self):
+        self.assertEqual(self.obj.overload([1, 2]), "list(int)")
+        self.assertEqual(self.obj.overload([]), "list(int)")
+
+    def testNoMatch(self):
+        self.assertRaises(TypeError, self.obj.overload, Dummy())
+        self.assertRaises(TypeError, self.obj.overload, [ImplicitBase()])
+
 class EnumOverIntSorting(unittest.TestCase):
     def testEnumOverInt(self):
         ic = ImplicitConv(ImplicitConv.CtorTwo)
@@ -0,0 +1,63 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the module initialization profile of bindings generated with --startup-profile.'''
+
+import os
+import subprocess
+import sys
+import unittest
+
+generatedWithStartupProfile = '--startup-profile' in os.environ.get('SHIBOKEN_GENERATOR_FLAGS', '').split()
+
+class StartupProfileTest(unittest.TestCase):
+
+    def importSample(self, environment):
+        process = subprocess.Popen([sys.executable, '-c', 'import sample'], env=environment,
+                                   stderr=subprocess.PIPE)
+        error = process.communicate()[1].decode()
+        self.assertEqual(process.returncode, 0)
+        return error
+
+    def testReport(self):
+        if not generatedWithStartupProfile:
+            sys.stderr.write('skipped, sample was not generated with --startup-profile ')
+            return
+        environment = dict(os.environ)
+        environment['SHIBOKEN_STARTUP_PROFILE'] = '3'
+        lines = self.importSample(environment).splitlines()
+        self.assert_('Module initialization time: ms, module' in lines)
+        self.assert_([line for line in lines if line.split()[-1:] == ['sample']])
+        steps = lines[lines.index('Slowest module initialization steps: ms, module, step') + 1:]
+        self.assert_(0 < len(steps) <= 3)
+
+    def testDisabled(self):
+        environment = dict(os.environ)
+        environment.pop('SHIBOKEN_STARTUP_PROFILE', None)
+        self.assert_('Module initialization time' not in self.importSample(environment))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,75 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the tracing of wrapper lifetime and GIL events.'''
+
+import json
+import os
+import tempfile
+import unittest
+
+from sample import Event, ObjectType, dumpTrace, setTraceEnabled
+
+class ExtObjectType(ObjectType):
+    def event(self, event):
+        return True
+
+class TraceTest(unittest.TestCase):
+
+    def tracedEvents(self):
+        fd, fileName = tempfile.mkstemp(suffix='.json')
+        os.close(fd)
+        try:
+            self.assert_(dumpTrace(fileName))
+            return json.load(open(fileName))['traceEvents']
+        finally:
+            os.remove(fileName)
+
+    def testEvents(self):
+        setTraceEnabled(True)
+        parent = ObjectType()
+        child = ExtObjectType()
+        child.setParent(parent)
+        ObjectType.processEvent([child], Event(Event.BASIC_EVENT))
+        del parent
+        del child
+        setTraceEnabled(False)
+
+        events = self.tracedEvents()
+        names = set([event['name'] for event in events])
+        for name in ('wrapper created', 'wrapper destroyed', 'parent set', 'virtual override dispatched'):
+            self.assert_(name in names)
+        overrides = [event for event in events if event['name'] == 'virtual override dispatched']
+        self.assertEqual(overrides[-1]['args']['name'], 'event')
+
+    def testDisabled(self):
+        setTraceEnabled(False)
+        count = len(self.tracedEvents())
+        ObjectType()
+        self.assertEqual(len(self.tracedEvents()), count)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This file is part of the Shiboken Python Bindings Generator project.
+#
+# Copyright (C) 2009 Nokia Corporation and/or its subsidiary(-ies).
+#
+# Contact: PySide team <contact@pyside.org>
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# version 2.1 as published by the Free Software Foundation. Please
+# review the following information to ensure the GNU Lesser General
+# Public License version 2.1 requirements will be met:
+# http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+# #
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+# 02110-1301 USA
+
+'''Test cases for the initialization of the module types, lazy or not.'''
+
+import subprocess
+import sys
+import unittest
+
+import sample
+
+def runInFreshInterpreter(code):
+    '''Runs code in a new interpreter, where sample was not imported yet.'''
+    return subprocess.call([sys.executable, '-c', code])
+
+class TypeInitializationTest(unittest.TestCase):
+    '''Types must be available however they are first reached.'''
+
+    def testConversionBeforeAttributeAccess(self):
+        '''A C++ object converted to Python before its type is accessed gets the proper type.'''
+        code = ('import sample\n'
+                'point = sample.transmuteComplexIntoPoint(complex(1, 2))\n'
+                'assert type(point).__name__ == "Point"\n'
+                'assert type(point) is sample.Point\n')
+        self.assertEqual(runInFreshInterpreter(code), 0)
+
+    def testBaseTypeComesWithDerived(self):
+        '''Accessing a derived type makes its base types available.'''
+        code = ('import sample\n'
+                'mro = sample.Derived.__mro__\n'
+                'assert mro[1] is sample.Abstract\n')
+        self.assertEqual(runInFreshInterpreter(code), 0)
+
+    def testInnerClassAndEnums(self):
+        '''Inner classes and enums come along with the enclosing class.'''
+        code = ('import sample\n'
+                'inner = sample.Derived.SomeInnerClass()\n'
+                'assert type(inner) is sample.Derived.SomeInnerClass\n'
+                'result = sample.Derived().otherOverloaded(1, 2.2)\n'
+                'assert type(result) is sample.Derived.OtherOverloadedFuncEnum\n')
+        self.assertEqual(runInFreshInterpreter(code), 0)
+
+    def testDiscoveryOfUnusedDerivedType(self):
+        '''A base pointer to an instance of a derived type not used yet gets the derived type.'''
+        code = ('import sample\n'
+                'layout = sample.ObjectType.createLayout()\n'
+                'assert type(layout).__name__ == "ObjectTypeLayout"\n'
+                'assert type(layout) is sample.ObjectTypeLayout\n')
+        self.assertEqual(runInFreshInterpreter(code), 0)
+
+    def testUnknownAttribute(self):
+        '''Names that are not types of the module still raise AttributeError.'''
+        self.assertRaises(AttributeError, getattr, sample, 'NotAType')
+
+if __name__ == '__main__':
+    unittest.main()